@@ -0,0 +1,204 @@
+#include <curses.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+#include "ncurses_display.h"
+#include "proc_fixture.h"
+#include "snapshot.h"
+#include "system.h"
+
+using std::string;
+using std::vector;
+
+// Every global allocation made by the process, including the monitor code
+// under measurement
+static std::atomic<unsigned long> allocations{0};
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+namespace {
+// Command line settings of the benchmark
+struct Settings {
+  vector<int> pids{1000, 10000};
+  int ticks{5};
+  int threads{1};
+  string keep;
+};
+
+// Time and allocations of one phase, averaged over the measured ticks
+struct Result {
+  double ns_per_tick{0};
+  double allocations_per_tick{0};
+};
+
+template <typename Function>
+Result Measure(int ticks, Function function) {
+  function();  // warm up caches, buffers and the process table
+  const unsigned long before = allocations.load();
+  const auto start = std::chrono::steady_clock::now();
+  for (int tick = 0; tick < ticks; ++tick) {
+    function();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  Result result;
+  result.ns_per_tick =
+      std::chrono::duration<double, std::nano>(elapsed).count() / ticks;
+  result.allocations_per_tick =
+      static_cast<double>(allocations.load() - before) / ticks;
+  return result;
+}
+
+void Report(const char* phase, int pids, const Result& result) {
+  std::printf("%-12s %8d %12.0f %10.3f %14.1f\n", phase, pids,
+              result.ns_per_tick / pids, result.ns_per_tick / 1e6,
+              result.allocations_per_tick);
+}
+
+vector<int> ParseList(const string& value) {
+  vector<int> result;
+  std::istringstream stream(value);
+  string item;
+  while (std::getline(stream, item, ',')) {
+    result.push_back(std::atoi(item.c_str()));
+  }
+  return result;
+}
+
+bool Parse(int argc, char* argv[], Settings& settings) {
+  for (int i = 1; i < argc; ++i) {
+    const string argument{argv[i]};
+    const auto equals = argument.find('=');
+    const string name = argument.substr(0, equals);
+    const string value =
+        equals == string::npos ? string() : argument.substr(equals + 1);
+    if (name == "--pids") {
+      settings.pids = ParseList(value);
+    } else if (name == "--ticks") {
+      settings.ticks = std::max(1, std::atoi(value.c_str()));
+    } else if (name == "--threads") {
+      settings.threads = std::max(1, std::atoi(value.c_str()));
+    } else if (name == "--keep") {
+      settings.keep = value;
+    } else {
+      return false;
+    }
+  }
+  return !settings.pids.empty();
+}
+
+void Run(const Settings& settings, int pids) {
+  const string root = settings.keep.empty()
+                          ? ProcFixture::MakeTemporaryDirectory()
+                          : settings.keep;
+  ProcFixture::Settings fixture;
+  fixture.pids = pids;
+  std::error_code error;
+  std::filesystem::create_directories(root, error);
+  if (root.empty() || !ProcFixture::Write(root, fixture)) {
+    std::fprintf(stderr, "monitor_bench: cannot write fixture in %s\n",
+                 root.c_str());
+    std::exit(1);
+  }
+  LinuxParser::SetProcDirectory(root);
+
+  vector<int> pid_list;
+  Report("scan", pids, Measure(settings.ticks, [&] {
+           LinuxParser::Pids(pid_list);
+         }));
+
+  LinuxParser::ProcStat stat;
+  LinuxParser::ProcStatus status;
+  Report("parse", pids, Measure(settings.ticks, [&] {
+           for (const int pid : pid_list) {
+             LinuxParser::ReadProcStat(pid, stat);
+             LinuxParser::ReadProcStatus(pid, status);
+           }
+         }));
+
+  System system(settings.threads);
+  Report("refresh", pids,
+         Measure(settings.ticks, [&] { system.Refresh(); }));
+
+  Snapshot published;
+  Report("snapshot", pids, Measure(settings.ticks, [&] {
+           system.TakeSnapshot(published);
+         }));
+
+  // Render into a terminal whose output is discarded. Two snapshots in
+  // different orders are drawn in turn so every frame has rows to rewrite.
+  FILE* output = std::fopen("/dev/null", "w");
+  FILE* input = std::fopen("/dev/null", "r");
+  SCREEN* screen = newterm("xterm", output, input);
+  if (screen != nullptr) {
+    start_color();
+    NCursesDisplay::Panel system_panel(20, 120, 0, 0);
+    NCursesDisplay::Panel process_panel(13, 120, 20, 0);
+    Snapshot snapshots[2];
+    system.TakeSnapshot(snapshots[0]);
+    system.SortBy(SortKey::kPid);
+    system.TakeSnapshot(snapshots[1]);
+    NCursesDisplay::SetupSystem(snapshots[0], system_panel);
+    NCursesDisplay::SetupProcesses(process_panel);
+    int frame{0};
+    long first_bytes{0};
+    long bytes{0};
+    auto render = [&] {
+      const Snapshot& snapshot = snapshots[frame++ % 2];
+      NCursesDisplay::DisplaySystem(snapshot, system_panel);
+      NCursesDisplay::DisplayProcesses(snapshot, process_panel, 10);
+      system_panel.Stage();
+      process_panel.Stage();
+      const long written = NCursesDisplay::Flush();
+      (frame == 1 ? first_bytes : bytes) += written;
+    };
+    const Result result = Measure(settings.ticks, render);
+    Report("render", pids, result);
+    std::printf("%-12s %8d %12s first frame %ld bytes, then %.0f bytes/frame\n",
+                "terminal", pids, "", first_bytes,
+                static_cast<double>(bytes) / (frame - 1));
+    endwin();
+    delscreen(screen);
+  }
+  std::fclose(input);
+  std::fclose(output);
+
+  if (settings.keep.empty()) {
+    ProcFixture::Remove(root);
+  }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Settings settings;
+  if (!Parse(argc, argv, settings)) {
+    std::fprintf(stderr,
+                 "usage: monitor_bench [--pids=<n>[,<n>...]] [--ticks=<n>] "
+                 "[--threads=<n>] [--keep=<dir>]\n");
+    return 1;
+  }
+  std::printf("%-12s %8s %12s %10s %14s\n", "phase", "pids", "ns/pid",
+              "ms/tick", "allocs/tick");
+  for (const int pids : settings.pids) {
+    Run(settings, pids);
+  }
+}
@@ -0,0 +1,198 @@
+#include "proc_fixture.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+using std::string;
+
+namespace {
+// Command lines and names of the synthetic processes. Some comm values
+// contain spaces and parentheses like real ones do.
+struct Program {
+  const char* comm;
+  const char* cmdline;
+};
+
+constexpr Program kPrograms[] = {
+    {"postgres", "postgres: worker process"},
+    {"java", "/usr/bin/java -Xmx4g -jar /opt/service/service.jar --port 8080"},
+    {"nginx", "nginx: worker process"},
+    {"bash", "-bash"},
+    {"python3", "/usr/bin/python3 /opt/jobs/batch.py --shard 17"},
+    {"kworker/3:1-events", ""},
+    {"tmux: server", "tmux new-session -d"},
+    {"(sd-pam)", "(sd-pam)"},
+    {"Web Content", "/usr/lib/firefox/firefox -contentproc -childID 12"},
+};
+
+constexpr int kUids[] = {0, 0, 0, 1000, 1000, 33, 65534};
+
+bool WriteFile(const string& path, const string& contents) {
+  std::ofstream stream(path, std::ios::binary);
+  stream << contents;
+  return static_cast<bool>(stream);
+}
+
+string StatLine(int pid, const Program& program, std::mt19937& random) {
+  std::uniform_int_distribution<long> ticks(0, 500000);
+  const long starttime = ticks(random);
+  char line[1024];
+  std::snprintf(line, sizeof(line),
+                "%d (%s) S 1 %d %d 0 -1 4194560 %ld 0 %ld 0 %ld %ld %ld %ld "
+                "20 0 %ld 0 %ld %ld %ld 18446744073709551615 1 1 0 0 0 0 0 "
+                "4096 0 0 0 0 17 %d 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+                pid, program.comm, pid, pid, ticks(random), ticks(random) / 100,
+                ticks(random) / 10, ticks(random) / 20, ticks(random) / 100,
+                ticks(random) / 100, 1 + ticks(random) % 64, starttime,
+                ticks(random) * 4096, ticks(random) / 10,
+                static_cast<int>(pid % 8));
+  return line;
+}
+
+string StatusFile(int pid, const Program& program, int uid,
+                  std::mt19937& random) {
+  std::uniform_int_distribution<long> kilobytes(0, 4 << 20);
+  const long rss = kilobytes(random);
+  char text[2048];
+  std::snprintf(text, sizeof(text),
+                "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%d\n"
+                "Ngid:\t0\nPid:\t%d\nPPid:\t1\nTracerPid:\t0\n"
+                "Uid:\t%d\t%d\t%d\t%d\nGid:\t%d\t%d\t%d\t%d\nFDSize:\t64\n"
+                "Groups:\t\nNStgid:\t%d\nNSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n"
+                "VmPeak:\t%ld kB\nVmSize:\t%ld kB\nVmLck:\t0 kB\nVmPin:\t0 kB\n"
+                "VmHWM:\t%ld kB\nVmRSS:\t%ld kB\nRssAnon:\t%ld kB\n"
+                "RssFile:\t%ld kB\nRssShmem:\t0 kB\nVmData:\t%ld kB\n"
+                "VmStk:\t132 kB\nVmExe:\t1024 kB\nVmLib:\t8192 kB\n"
+                "VmPTE:\t256 kB\nVmSwap:\t0 kB\nHugetlbPages:\t0 kB\n"
+                "CoreDumping:\t0\nTHP_enabled:\t1\nThreads:\t4\n"
+                "SigQ:\t0/63429\nSigPnd:\t0000000000000000\n"
+                "ShdPnd:\t0000000000000000\nSigBlk:\t0000000000000000\n"
+                "SigIgn:\t0000000000001000\nSigCgt:\t0000000180004a03\n"
+                "CapInh:\t0000000000000000\nCapPrm:\t0000000000000000\n"
+                "CapEff:\t0000000000000000\nCapBnd:\t000001ffffffffff\n"
+                "CapAmb:\t0000000000000000\nNoNewPrivs:\t0\nSeccomp:\t0\n"
+                "Seccomp_filters:\t0\nSpeculation_Store_Bypass:\tvulnerable\n"
+                "Cpus_allowed:\tff\nCpus_allowed_list:\t0-7\n"
+                "Mems_allowed:\t1\nMems_allowed_list:\t0\n"
+                "voluntary_ctxt_switches:\t%ld\n"
+                "nonvoluntary_ctxt_switches:\t%ld\n",
+                program.comm, pid, pid, uid, uid, uid, uid, uid, uid, uid, uid,
+                pid, pid, pid, pid, rss * 3, rss * 2, rss + 100, rss,
+                rss * 3 / 4, rss / 4, rss, kilobytes(random),
+                kilobytes(random) / 100);
+  return text;
+}
+
+string Cmdline(const Program& program) {
+  string cmdline{program.cmdline};
+  if (cmdline.empty()) {
+    return cmdline;
+  }
+  // Arguments are NUL separated and terminated
+  for (auto& c : cmdline) {
+    if (c == ' ') {
+      c = '\0';
+    }
+  }
+  return cmdline + '\0';
+}
+
+string SystemStat(int cores, int pids, std::mt19937& random) {
+  std::uniform_int_distribution<long> ticks(1000, 9000000);
+  string text;
+  char line[256];
+  for (int core = -1; core < cores; ++core) {
+    const string name = core < 0 ? "cpu " : "cpu" + std::to_string(core);
+    const long scale = core < 0 ? cores : 1;
+    std::snprintf(line, sizeof(line),
+                  "%s %ld %ld %ld %ld %ld %ld %ld 0 0 0\n", name.c_str(),
+                  scale * ticks(random), scale * ticks(random) / 100,
+                  scale * ticks(random) / 4, scale * ticks(random) * 4,
+                  scale * ticks(random) / 50, scale * ticks(random) / 100,
+                  scale * ticks(random) / 100);
+    text += line;
+  }
+  text += "intr 123456789";
+  for (int i = 0; i < 256; ++i) {
+    text += i % 7 == 0 ? " 12345" : " 0";
+  }
+  std::snprintf(line, sizeof(line),
+                "\nctxt 987654321\nbtime 1700000000\nprocesses %d\n"
+                "procs_running %d\nprocs_blocked 0\n"
+                "softirq 1000 0 100 0 200 0 0 300 0 0 400\n",
+                pids * 10, 1 + pids / 100);
+  return text + line;
+}
+
+// A cgroup v2 membership, in one of a few sessions per user
+string CgroupFile(int pid, int uid) {
+  return "0::/user.slice/user-" + std::to_string(uid) + ".slice/session-" +
+         std::to_string(pid % 4) + ".scope\n";
+}
+}  // namespace
+
+// Write a proc tree with system files and settings.pids process directories,
+// each holding stat, status, cmdline and cgroup
+bool ProcFixture::Write(const string& root, const Settings& settings) {
+  std::mt19937 random(settings.seed);
+  bool ok = WriteFile(root + "/stat",
+                      SystemStat(settings.cores, settings.pids, random)) &&
+            WriteFile(root + "/meminfo",
+                      "MemTotal:       65807708 kB\n"
+                      "MemFree:         1934876 kB\n"
+                      "MemAvailable:   41207368 kB\n"
+                      "Buffers:         2096744 kB\n"
+                      "Cached:         35233040 kB\n"
+                      "SwapCached:            0 kB\n"
+                      "Active:         22101432 kB\n"
+                      "Inactive:       37420372 kB\n"
+                      "Dirty:              1372 kB\n"
+                      "Slab:            3650168 kB\n"
+                      "SwapTotal:       8388604 kB\n"
+                      "SwapFree:        8388604 kB\n") &&
+            WriteFile(root + "/uptime", "523456.78 4012345.67\n") &&
+            WriteFile(root + "/loadavg", "3.52 2.91 2.40 5/" +
+                                             std::to_string(settings.pids) +
+                                             " 123456\n") &&
+            WriteFile(root + "/version",
+                      "Linux version 6.1.0-fixture (bench@fixture) (gcc) #1 "
+                      "SMP PREEMPT_DYNAMIC\n");
+
+  for (int i = 0; ok && i < settings.pids; ++i) {
+    const int pid = 100 + i;
+    const auto& program =
+        kPrograms[random() % (sizeof(kPrograms) / sizeof(kPrograms[0]))];
+    const int uid = kUids[random() % (sizeof(kUids) / sizeof(kUids[0]))];
+    const string directory = root + "/" + std::to_string(pid);
+    ok = mkdir(directory.c_str(), 0755) == 0 &&
+         WriteFile(directory + "/stat", StatLine(pid, program, random)) &&
+         WriteFile(directory + "/status",
+                   StatusFile(pid, program, uid, random)) &&
+         WriteFile(directory + "/cmdline", Cmdline(program)) &&
+         WriteFile(directory + "/cgroup", CgroupFile(pid, uid));
+  }
+  return ok;
+}
+
+// Create a fresh directory for a fixture, returning "" on failure
+string ProcFixture::MakeTemporaryDirectory() {
+  const char* base = std::getenv("TMPDIR");
+  string pattern = string(base != nullptr ? base : "/tmp") + "/procXXXXXX";
+  if (mkdtemp(pattern.data()) == nullptr) {
+    return string();
+  }
+  return pattern;
+}
+
+// Delete a fixture tree
+void ProcFixture::Remove(const string& root) {
+  std::error_code error;
+  std::filesystem::remove_all(root, error);
+}
@@ -0,0 +1,19 @@
+#ifndef PROC_FIXTURE_H
+#define PROC_FIXTURE_H
+
+#include <string>
+
+namespace ProcFixture {
+// Shape of a synthetic /proc tree
+struct Settings {
+  int pids{1000};
+  int cores{8};
+  unsigned int seed{1};
+};
+
+bool Write(const std::string& root, const Settings& settings);
+std::string MakeTemporaryDirectory();
+void Remove(const std::string& root);
+};  // namespace ProcFixture
+
+#endif
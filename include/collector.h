@@ -0,0 +1,61 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "filter.h"
+#include "refresh_scheduler.h"
+#include "snapshot.h"
+#include "snapshot_source.h"
+#include "system.h"
+#include "triple_buffer.h"
+
+/*
+Refreshes a System on a dedicated thread, as often as the scheduler says,
+and publishes a Snapshot after every refresh through a lock-free triple
+buffer. The render loop picks up the
+latest snapshot whenever it likes, so a slow /proc walk never blocks input
+handling or drawing.
+*/
+class Collector : public SnapshotSource {
+ public:
+  Collector(System& system, RefreshScheduler scheduler);
+  ~Collector() override;
+  Collector(const Collector&) = delete;
+  Collector& operator=(const Collector&) = delete;
+
+  // Consumer side, called from one thread only
+  bool Update() override;
+  const Snapshot& Current() const override;
+
+  void SortBy(SortKey key) override;
+  void ShowThreads(int pid) override;
+  bool SetFilter(const Filter& filter) override;
+  void Collect(unsigned sources) override;
+
+ private:
+  void Loop();
+  void Publish();
+  bool Changed() const;
+  void Apply();
+
+  System& system_;
+  RefreshScheduler scheduler_;
+  TripleBuffer<Snapshot> snapshots_;
+  unsigned long sequence_{0};
+  std::atomic<SortKey> sort_key_;
+  std::atomic<int> threads_pid_;
+  std::atomic<unsigned> sources_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_{false};
+  Filter filter_;  // waiting to be applied, guarded by mutex_
+  bool filter_changed_{false};
+  std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+/*
+Registry of the process columns. Each column declares the files of
+/proc/[pid] its value comes from, so the collector can derive what to read
+per PID from the columns on screen, the sort key and the views in use:
+with only PID and CPU shown, a refresh reads one stat per PID.
+*/
+namespace Columns {
+// Files of /proc/[pid], as bits of a set
+enum Source : unsigned {
+  kStat = 1u << 0,
+  kStatus = 1u << 1,
+  kCgroup = 1u << 2,
+  kCmdline = 1u << 3,
+  kIo = 1u << 4,
+  kSmapsRollup = 1u << 5,
+};
+constexpr unsigned kAllSources{kStat | kStatus | kCgroup | kCmdline | kIo |
+                               kSmapsRollup};
+// The cgroup and user rollups
+constexpr unsigned kGroupSources{kStat | kStatus | kCgroup};
+
+enum class Id {
+  kPid,
+  kUser,
+  kCpu,
+  kRam,
+  kPss,
+  kSwap,
+  kRead,
+  kWrite,
+  kFaults,
+  kTime,
+  kCommand
+};
+
+struct Column {
+  Id id;
+  const char* name;   // as given to --columns
+  const char* title;  // header
+  int width;          // up to the next column; the last takes the rest
+  unsigned sources;
+  bool sortable;
+  SortKey sort_key;
+};
+
+const Column& Get(Id id);
+const std::vector<Id>& Defaults();
+bool Parse(const std::string& names, std::vector<Id>& columns,
+           std::string& error);
+unsigned Sources(const std::vector<Id>& columns);
+unsigned Sources(SortKey key);
+};  // namespace Columns
+
+#endif
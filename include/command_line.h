@@ -0,0 +1,38 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <string>
+#include <vector>
+
+#include "columns.h"
+
+namespace CommandLine {
+// Settings of the monitor taken from the command line
+struct Options {
+  int threads{DefaultThreads()};
+  int top{10};
+  bool batch{false};
+  int interval_ms{1000};
+  int count{0};
+  std::string format{"ndjson"};
+  std::string proc_root;
+  bool netlink{false};
+  bool self_stats{false};
+  bool groups{false};
+  int history_minutes{5};
+  std::string record;
+  std::string replay;
+  std::string filter;
+  std::vector<Columns::Id> columns{Columns::Defaults()};
+  double budget_percent{1};
+  std::vector<int> watch;
+  std::string listen;
+
+  static int DefaultThreads();
+};
+
+bool Parse(int argc, char* argv[], Options& options, std::string& error);
+std::string Usage();
+};  // namespace CommandLine
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+A compiled process filter such as
+
+  user==postgres && cpu>5 && cmd~"worker"
+
+Comparisons are joined with &&, || and !, and grouped with parentheses.
+Numbers compare with == != < <= > >=, strings with == != and ~ or !~ for a
+regular expression search. Fields, from the cheapest to the most expensive
+to know:
+
+  pid                 the PID, known before anything is read
+  ppid, state, comm   from /proc/[pid]/stat
+  ram, time           resident memory in MB and age in seconds, from stat
+  uid, user           the owner, from /proc/[pid]/status
+  cmd                 the command line, from /proc/[pid]/cmdline
+  cpu                 utilization in percent, known once the table is merged
+
+The operands of && and || are ordered by that cost when compiled, and a
+record is evaluated with whatever is known of it so far: a comparison of an
+unknown field is unknown, and false && unknown is false. The collector reads
+the next file of a PID only while its answer is still unknown.
+*/
+class Filter {
+ public:
+  enum class Match { kNo, kYes, kUnknown };
+  enum class Cost { kFree, kStat, kStatus, kCmdline, kUsage };
+
+  // What is known of one process; fields not read yet are left unknown
+  struct Record {
+    int pid{0};
+    bool has_stat{false};
+    int ppid{0};
+    char state{'?'};
+    std::string_view comm;
+    long ram_kb{0};
+    long uptime{0};  // seconds
+    int uid{-1};
+    std::optional<std::string_view> command;
+    float cpu{-1};
+  };
+
+  bool Compile(const std::string& text, std::string& error);
+  bool Empty() const;
+  const std::string& Text() const;
+  bool Reads(Cost cost) const;
+  Match Evaluate(const Record& record) const;
+
+  struct Node;
+
+ private:
+  std::string text_;
+  std::shared_ptr<const Node> root_;
+  unsigned reads_{0};  // bit per Cost read by some comparison
+};
+
+#endif
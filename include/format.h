@@ -5,6 +5,7 @@
 
 namespace Format {
 std::string ElapsedTime(long times);
+std::string Bytes(double bytes);
 };  // namespace Format
 
 #endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+Fixed-capacity history of the system and of a bounded number of processes.
+Every series is a ring of compact fixed-point samples stored
+structure-of-arrays, and all rings share one write position: utilization in
+hundredths of a percent, resident memory in kB. Processes get one of kSlots
+slots when they are first shown and keep it while they live; when the slots
+run out the one shown least recently is recycled, so memory stays bounded
+however many PIDs come and go. Samples are timestamped, and with a window
+set only those no older than the window are read back, so the history spans
+the same time however the interval between ticks varies.
+*/
+class History {
+ public:
+  static constexpr std::uint16_t kScale{10000};  // utilization of 1.0
+  static constexpr std::size_t kSlots{128};
+  // Largest capacity, an hour at four ticks per second; about 11 MB
+  static constexpr std::size_t kMaxCapacity{14400};
+
+  explicit History(std::size_t capacity = 300, long long window_ms = 0);
+  static std::size_t CapacityFor(long long window_ms, long long interval_ms);
+  std::size_t Capacity() const;
+  long long Window() const;
+  std::size_t Size() const;
+  std::size_t Length() const;
+
+  // Writing, once per tick: Begin() with the system sample, then Record()
+  // for every tracked slot whose process is still alive, then End()
+  void Begin(long long time_ms, float cpu, float memory,
+             const std::vector<float>& cores);
+  int Track(int pid, long start_time);
+  int SlotPid(std::size_t slot) const;
+  long SlotStartTime(std::size_t slot) const;
+  void Record(std::size_t slot, float cpu, long rss_kb);
+  void End();
+
+  // Reading, oldest sample first
+  void Cpu(std::vector<std::uint16_t>& samples) const;
+  void Memory(std::vector<std::uint16_t>& samples) const;
+  void Core(std::size_t core, std::vector<std::uint16_t>& samples) const;
+  std::size_t Cores() const;
+  bool Process(int pid, std::vector<std::uint16_t>& cpu,
+               std::vector<std::uint32_t>& rss) const;
+
+  static std::uint16_t Fixed(float utilization);
+
+ private:
+  template <typename T>
+  void Copy(const T* ring, std::size_t count, std::vector<T>& samples) const;
+
+  std::size_t capacity_;
+  long long window_ms_;  // 0 keeps every sample the capacity allows
+  unsigned long ticks_{0};
+  std::size_t head_{0};  // position of the latest sample
+  std::size_t size_{0};  // samples within the window
+
+  std::vector<long long> times_;
+  std::vector<std::uint16_t> cpu_;
+  std::vector<std::uint16_t> memory_;
+  std::vector<std::uint16_t> cores_;  // capacity_ samples per core
+
+  // Process slots
+  std::vector<int> slot_pid_;
+  std::vector<long> slot_start_;
+  std::vector<unsigned long> slot_first_;     // tick of the first sample
+  std::vector<unsigned long> slot_recorded_;  // tick of the latest sample
+  std::vector<unsigned long> slot_shown_;     // tick it was last tracked
+  std::vector<std::uint16_t> slot_cpu_;       // capacity_ samples per slot
+  std::vector<std::uint32_t> slot_rss_;
+  std::unordered_map<int, int> slot_of_;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstdint>
+
+/*
+Low-overhead counters for the monitor's own cost: wall time of each phase of
+a refresh and the syscalls and bytes spent reading /proc. Every thread adds
+to its own block of counters; Collect() sums the blocks once per tick.
+Building without MONITOR_INSTRUMENTATION compiles all of it out.
+*/
+namespace Instrumentation {
+enum Phase {
+  kScan = 0,
+  kParse,
+  kSort,
+  kRenderSystem,
+  kRenderProcesses,
+  kPhaseCount
+};
+
+enum Counter { kOpens = 0, kReads, kBytesRead, kProcEvents, kCounterCount };
+
+// Totals of one tick
+struct Tick {
+  std::int64_t phase_ns[kPhaseCount]{};
+  std::uint64_t counters[kCounterCount]{};
+};
+
+const char* PhaseName(Phase phase);
+const char* CounterName(Counter counter);
+
+#ifdef MONITOR_INSTRUMENTATION
+constexpr bool kEnabled{true};
+
+void Add(Counter counter, std::uint64_t value);
+void AddTime(Phase phase, std::int64_t ns);
+Tick Collect();
+
+// Adds the lifetime of the timer to a phase
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Phase phase);
+  ~ScopedTimer();
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Phase phase_;
+  std::int64_t start_;
+};
+#else
+constexpr bool kEnabled{false};
+
+inline Tick Collect() { return Tick{}; }
+#endif
+};  // namespace Instrumentation
+
+#ifdef MONITOR_INSTRUMENTATION
+#define MONITOR_CONCAT_(a, b) a##b
+#define MONITOR_CONCAT(a, b) MONITOR_CONCAT_(a, b)
+#define MONITOR_TIME_PHASE(phase)                           \
+  Instrumentation::ScopedTimer MONITOR_CONCAT(monitor_timer_, \
+                                              __LINE__)(Instrumentation::phase)
+#define MONITOR_COUNT(counter, value) \
+  Instrumentation::Add(Instrumentation::counter, value)
+#else
+#define MONITOR_TIME_PHASE(phase) static_cast<void>(0)
+#define MONITOR_COUNT(counter, value) static_cast<void>(0)
+#endif
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <cstddef>
 #include <fstream>
+#include <memory_resource>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace LinuxParser {
 // Paths
@@ -14,18 +18,73 @@ const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
+const std::string kVmstatFilename{"/vmstat"};
+const std::string kPressureDirectory{"/pressure/"};
+const std::string kLoadavgFilename{"/loadavg"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
+const std::string kSelfIoPath{"/proc/self/io"};
+const std::string kCgroupFilename{"/cgroup"};
+const std::string kTaskDirectory{"/task/"};
+const std::string kIoFilename{"/io"};
+const std::string kSmapsRollupFilename{"/smaps_rollup"};
+const std::string kMountsPath{"/proc/self/mounts"};
 
 // System
+const std::string& ProcDirectory();
+void SetProcDirectory(const std::string& directory);
 float MemoryUtilization();
+
+// Fields of /proc/meminfo used by the monitor, in kB
+struct MemInfo {
+  long total{0};
+  long free{0};
+  long available{0};
+  long buffers{0};
+  long cached{0};
+  long slab{0};
+  long swap_total{0};
+  long swap_free{0};
+  long dirty{0};
+
+  float Utilization() const;
+};
+
+bool ReadMemInfo(MemInfo& meminfo);
+bool ParseMemInfo(const char* buffer, std::size_t size, MemInfo& meminfo);
+
+// Counters of /proc/vmstat used by the monitor, since boot
+struct VmStat {
+  long pgfault{0};
+  long pgmajfault{0};
+  long pswpin{0};
+  long pswpout{0};
+};
+
+bool ReadVmStat(VmStat& vmstat);
+
+// Pressure stall information of /proc/pressure/*: the percentage of time
+// some or all tasks were stalled on a resource, over 10, 60 and 300 seconds
+enum PressureResource { kPressureCpu = 0, kPressureMemory, kPressureIo };
+constexpr int kPressureResources{kPressureIo + 1};
+
+struct Pressure {
+  float some[3]{};
+  float full[3]{};
+};
+
+bool ReadPressure(PressureResource resource, Pressure& pressure);
 long UpTime();
+bool LoadAverage(float (&load)[3]);
 std::vector<int> Pids();
+void Pids(std::vector<int>& pids);
+void Tids(int pid, std::vector<int>& tids);
 int TotalProcesses();
 int RunningProcesses();
 std::string OperatingSystem();
 std::string Kernel();
+const std::string& CgroupMount();
 
 // CPU
 enum CPUStates {
@@ -41,6 +100,29 @@ enum CPUStates {
   kGuestNice_
 };
 
+// Jiffies of one "cpu" line of /proc/stat, indexed by CPUStates
+struct CpuTimes {
+  long jiffies[kGuestNice_ + 1]{};
+
+  long Total() const;
+  long Idle() const;
+  long Active() const;
+};
+
+// Everything the monitor uses from /proc/stat, parsed in a single pass
+struct StatSnapshot {
+  CpuTimes cpu;
+  std::vector<CpuTimes> cores;
+  long ctxt{0};
+  long intr{0};
+  long processes{0};
+  int procs_running{0};
+  int procs_blocked{0};
+};
+
+bool ReadStatSnapshot(StatSnapshot& snapshot);
+bool ParseStatSnapshot(const char* buffer, std::size_t size,
+                       StatSnapshot& snapshot);
 std::vector<std::string> CpuUtilization();
 long Jiffies();
 long ActiveJiffies();
@@ -48,10 +130,54 @@ long ActiveJiffies(int pid);
 long IdleJiffies();
 
 // Processes
+// Fields of /proc/[pid]/stat used by the monitor (see proc(5))
+struct ProcStat {
+  int pid{0};
+  char comm[64]{};
+  char state{'?'};
+  int ppid{0};
+  long utime{0};
+  long stime{0};
+  long cutime{0};
+  long cstime{0};
+  long num_threads{0};
+  long majflt{0};
+  long starttime{0};
+  long rss{0};  // pages
+};
+
+// Fields of /proc/[pid]/status used by the monitor
+struct ProcStatus {
+  int uid{-1};
+  long vm_rss{0};  // kB
+};
+
+bool ReadProcStat(int pid, ProcStat& stat);
+bool ReadTaskStat(int pid, int tid, ProcStat& stat);
+bool ParseProcStat(const char* buffer, std::size_t size, ProcStat& stat);
+bool ReadProcStatus(int pid, ProcStatus& status);
+
+// Storage I/O of /proc/[pid]/io, in bytes
+struct ProcIo {
+  long read_bytes{0};
+  long write_bytes{0};
+};
+
+// Memory of /proc/[pid]/smaps_rollup, in kB
+struct ProcMemory {
+  long pss{0};
+  long swap{0};
+};
+
+bool ReadProcIo(int pid, ProcIo& io);
+bool ReadProcMemory(int pid, ProcMemory& memory);
+bool ReadProcCgroup(int pid, std::pmr::string& path);
 std::string Command(int pid);
+void Command(int pid, std::pmr::string& command);
 std::string Ram(int pid);
 std::string Uid(int pid);
 std::string User(int pid);
+std::string UserName(int uid);
 long int UpTime(int pid);
 
 // Readers
@@ -60,6 +186,7 @@ long ReadProcessID(const int &pid, const std::string key);
 
 // Helper Functions
 int ClockTicksPerSecond();
+long WrittenBytes();
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <string>
+
+#include "snapshot_source.h"
+
+/*
+A minimal HTTP/1.1 server for /metrics. Serve() runs on one thread and is
+the only consumer of the source, so a scrape renders the latest published
+snapshot and never touches /proc. Collection goes on in the source's own
+thread, so scrapes do not block it. The exposition is rendered once per
+snapshot and shared by every scrape until the next one. Connections are
+answered one at a time and closed; a client that stalls is dropped after
+kClientTimeout rather than holding up the others.
+*/
+class MetricsServer {
+ public:
+  MetricsServer() = default;
+  ~MetricsServer();
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  bool Listen(const std::string& address, std::string& error);
+  void Serve(SnapshotSource& source);
+
+ private:
+  void Answer(int client, SnapshotSource& source);
+
+  int socket_{-1};
+  unsigned long sequence_{0};
+  std::string body_;
+  std::string request_;
+  std::string response_;
+};
+
+#endif
@@ -3,14 +3,81 @@
 
 #include <curses.h>
 
-#include "process.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "columns.h"
+#include "instrumentation.h"
+#include "linux_parser.h"
+#include "refresh_scheduler.h"
+#include "snapshot.h"
+#include "snapshot_source.h"
 #include "system.h"
 
 namespace NCursesDisplay {
-void Display(System& system, int n = 10);
-void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
+/*
+A boxed window together with a copy of every cell last drawn into it. Put()
+compares against that copy and hands ncurses only the cells that changed,
+so unchanged rows are never touched. Stage() queues the window with
+wnoutrefresh(); one doupdate() then writes all panels to the terminal.
+*/
+class Panel {
+ public:
+  Panel(int height, int width, int y, int x);
+  ~Panel();
+  Panel(const Panel&) = delete;
+  Panel& operator=(const Panel&) = delete;
+
+  WINDOW* Window() const { return window_; }
+  int Height() const { return height_; }
+  int Width() const { return width_; }
+  void Put(int row, int column, int width, const std::string& text,
+           attr_t attributes = A_NORMAL);
+  void Forget(int row);
+  void Clear();
+  void Stage();
+
+ private:
+  WINDOW* window_;
+  int height_;
+  int width_;
+  std::vector<chtype> cells_;
+  std::string line_;
+};
+
+void Display(System& system, int n = 10,
+             const std::vector<Columns::Id>& columns = Columns::Defaults(),
+             const RefreshScheduler& scheduler = RefreshScheduler());
+void Display(SnapshotSource& source, int n = 10,
+             const std::vector<Columns::Id>& columns = Columns::Defaults());
+void SetupSystem(const Snapshot& snapshot, Panel& panel);
+void SetupProcesses(Panel& panel);
+void DisplaySystem(const Snapshot& snapshot, Panel& panel,
+                   bool history = false);
+void DisplayProcesses(
+    const Snapshot& snapshot, Panel& panel, int n, int selected = -1,
+    bool threads = false,
+    const std::vector<Columns::Id>& columns = Columns::Defaults());
+void DisplayGroups(const std::vector<GroupRow>& groups, const char* title,
+                   SortKey sort_key, Panel& panel, int n);
+void DisplayDetail(const ProcessRow& process, Panel& panel,
+                   std::size_t length);
+long Flush();
+bool SortKeyFor(int key, SortKey& sort_key);
+std::string CostLine(const Instrumentation::Tick& tick, long terminal_bytes);
 std::string ProgressBar(float percent);
+std::string CoreBar(int core, float percent);
+std::string MemoryLine(const LinuxParser::MemInfo& meminfo);
+std::string PressureGauge(const char* resource, float percent);
+std::string Sparkline(const std::vector<std::uint16_t>& samples,
+                      std::size_t length, int width);
+std::string HistoryBar(float percent, const std::vector<std::uint16_t>& samples,
+                       std::size_t length);
+std::string CoreSparkline(int core, const std::vector<std::uint16_t>& samples,
+                          std::size_t length);
+int CoreRows(int cores, int width);
 };  // namespace NCursesDisplay
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,27 @@
+#ifndef NDJSON_OUTPUT_H
+#define NDJSON_OUTPUT_H
+
+#include <string>
+#include <vector>
+
+#include "columns.h"
+#include "instrumentation.h"
+#include "snapshot.h"
+#include "system.h"
+
+namespace NdjsonOutput {
+void Run(System& system, int interval_ms, int count, int n,
+         bool self_stats = false,
+         const std::vector<Columns::Id>& columns = Columns::Defaults(),
+         bool groups = false);
+void Watch(const std::vector<int>& pids, int interval_ms, int count);
+void AppendSnapshot(
+    const Snapshot& snapshot, std::string& out,
+    const std::vector<Columns::Id>& columns = Columns::Defaults(),
+    bool groups = false);
+void AppendGroups(const std::vector<GroupRow>& groups, std::string& out);
+void AppendCost(const Instrumentation::Tick& tick, std::string& out);
+void AppendString(const std::string& value, std::string& out);
+};  // namespace NdjsonOutput
+
+#endif
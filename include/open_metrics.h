@@ -0,0 +1,25 @@
+#ifndef OPEN_METRICS_H
+#define OPEN_METRICS_H
+
+#include <string>
+
+#include "snapshot.h"
+
+/*
+Renders a snapshot in the OpenMetrics text format: system CPU, per core
+utilization, memory, load, pressure, process counts and forks, and the CPU
+and resident memory of the top processes. The top processes are summed by
+user and executable name, with no PID label, so a series lasts as long as
+its program and does not start anew with every process that enters the
+list.
+*/
+namespace OpenMetrics {
+constexpr const char* kContentType{
+    "application/openmetrics-text; version=1.0.0; charset=utf-8"};
+
+void AppendSnapshot(const Snapshot& snapshot, std::string& out);
+void AppendLabel(const char* name, const std::string& value, std::string& out);
+std::string Executable(const std::string& command);
+};  // namespace OpenMetrics
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "history.h"
+#include "process.h"
+#include "recording.h"
+#include "snapshot.h"
+#include "snapshot_source.h"
+
+/*
+Plays a recording back through the display at the pace it was recorded,
+or faster. Only the frames being shown are decoded from the mapped file, so
+opening and seeking take the same time whatever the size of the recording.
+Keys: space pauses, left and right step one tick, 'f' changes the speed,
+'<' and '>' seek one minute, '{' and '}' ten minutes, Home and End jump to
+either end.
+*/
+class Player : public SnapshotSource {
+ public:
+  bool Open(const std::string& path, std::string& error);
+  void KeepHistory(std::chrono::milliseconds window);
+
+  bool Update() override;
+  const Snapshot& Current() const override;
+  void SortBy(SortKey key) override;
+  bool HandleKey(int key) override;
+  std::string Status() const override;
+
+  void Seek(long long time_ms);
+  bool StepForward();
+  bool StepBackward();
+
+ private:
+  bool Forward();
+  void Sample(bool continuous);
+  void Show();
+
+  Recording::Reader reader_;
+  Snapshot snapshot_;
+  std::size_t position_{0};  // frame shown
+  std::size_t next_{0};      // frame after it
+  bool paused_{false};
+  int speed_{1};
+  double pending_ms_{0};
+  std::chrono::steady_clock::time_point clock_;
+  bool changed_{false};
+  bool sorted_{false};
+  SortKey sort_key_{SortKey::kCpu};
+  History history_;
+  unsigned long sequence_{0};
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef PROC_FILE_H
+#define PROC_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+A system-wide /proc file that is opened once and re-read with pread at
+offset 0, so a steady-state read costs a single syscall and no allocation.
+If a read fails the file is reopened once before giving up.
+Not thread safe: each instance belongs to the thread that reads it.
+*/
+class ProcFile {
+ public:
+  explicit ProcFile(std::string path);
+  ~ProcFile();
+  ProcFile(const ProcFile&) = delete;
+  ProcFile& operator=(const ProcFile&) = delete;
+
+  bool Read(std::string_view& contents);
+
+ private:
+  bool Open();
+  void Close();
+  long ReadAll();
+
+  std::string path_;
+  int fd_{-1};
+  std::vector<char> buffer_;
+};
+
+#endif
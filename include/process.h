@@ -1,7 +1,14 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <chrono>
 #include <string>
+
+#include "linux_parser.h"
+
+// Orders a process list can be sorted in
+enum class SortKey { kCpu, kRam, kUpTime, kPid, kUser };
+
 /*
 Basic class for Process representation
 It contains relevant attributes as shown below
@@ -9,23 +16,68 @@ It contains relevant attributes as shown below
 class Process {
  public:
   Process(int pid);
+  Process(const LinuxParser::ProcStat& stat);
   int Pid() const;
   std::string User() const;
   std::string Command() const;
   float CpuUtilization() const;
   std::string Ram() const;
+  long RamKilobytes() const;
+  int Uid() const;
   long int UpTime() const;
   bool operator<(Process const& a) const;
   bool operator>(Process const& a) const;
   void CpuUtilization(long active_ticks, long system_ticks);
+  void Update(const LinuxParser::ProcStat& stat, long system_ticks);
+  void Update(const LinuxParser::ProcStatus& status);
+  void Update(const LinuxParser::ProcIo& io,
+              std::chrono::steady_clock::time_point now);
+  void Update(const LinuxParser::ProcMemory& memory);
+  long ActiveJiffies() const;
+  long StartTime() const;
+  const std::string& Comm() const;
+  int ParentPid() const;
+  char State() const;
+  // The command line and the user name only change with exec and setuid, so
+  // they are fetched once and kept until then
+  void ResolveCommand();
+  void ResolveUser();
+  void Exec();
+  void Command(std::string command);
+  const std::string* KnownCommand() const;
+  // Read lazily, for the processes on screen only; -1 until known
+  long PssKilobytes() const;
+  long SwapKilobytes() const;
+  float ReadRate() const;
+  float WriteRate() const;
+  float MajorFaultRate() const;
 
   // Declare private members
  private:
   int pid_;
-  float cpu_;
+  int ppid_{0};
+  char state_{'?'};
+  float cpu_{0};
+  long active_jiffies_{0};
+  long start_time_{0};
+  int uid_{-1};
+  long ram_{0};  // kB
+  std::string comm_;
+  std::string command_;
+  bool command_known_{false};
+  std::string user_;
+  int user_uid_{-1};  // UID user_ was resolved for
   long cached_active_jiffles_{0};
-  long cached_idle_jiffles_{0};
   long cached_system_jiffles_{0};
+  long majflt_{0};
+  float majflt_rate_{0};  // per second
+  long pss_{-1};   // kB
+  long swap_{-1};  // kB
+  long read_bytes_{0};
+  long write_bytes_{0};
+  float read_rate_{-1};   // bytes per second
+  float write_rate_{-1};  // bytes per second
+  std::chrono::steady_clock::time_point io_time_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef PROCESS_DISCOVERY_H
+#define PROCESS_DISCOVERY_H
+
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+
+/*
+Keeps the set of live PIDs. The scan backend reads the proc directory every
+tick. The netlink backend follows fork, exec and exit events from the
+kernel proc connector instead. It still reads the directory every
+kReconcileInterval, and straight away after events were lost. Subscribing
+needs CAP_NET_ADMIN and the real /proc; without either it falls back to
+scanning.
+*/
+class ProcessDiscovery {
+ public:
+  enum class Backend { kScan, kNetlink };
+
+  explicit ProcessDiscovery(Backend backend = Backend::kScan);
+  ~ProcessDiscovery();
+  ProcessDiscovery(const ProcessDiscovery&) = delete;
+  ProcessDiscovery& operator=(const ProcessDiscovery&) = delete;
+
+  Backend Active() const;
+  const std::vector<int>& Pids();
+  const std::vector<int>& Execs() const;
+
+ private:
+  bool Subscribe();
+  bool Drain();
+  void Close();
+
+  int socket_{-1};
+  bool reconcile_{true};
+  std::chrono::steady_clock::time_point reconciled_;
+  std::unordered_set<int> live_;
+  std::vector<int> pids_;
+  std::vector<int> execs_;
+};
+
+#endif
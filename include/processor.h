@@ -1,14 +1,30 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <vector>
+
+#include "linux_parser.h"
+
 class Processor {
  public:
-  float Utilization();
+  float Utilization() const;
+  const std::vector<float>& CoreUtilization() const;
+  void Update(const LinuxParser::StatSnapshot& snapshot);
 
   // DONE: Declare any necessary private members
  private:
-  long cached_active_jiffles_{0};
-  long cached_idle_jiffles_{0};
+  // Utilization of one CPU line between the last two snapshots
+  struct Counter {
+    float utilization{0};
+    long cached_active_jiffles{0};
+    long cached_idle_jiffles{0};
+
+    void Update(const LinuxParser::CpuTimes& times);
+  };
+
+  Counter total_ = {};
+  std::vector<Counter> cores_ = {};
+  std::vector<float> core_utilization_ = {};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,79 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "snapshot.h"
+#include "system.h"
+
+/*
+Binary recordings of monitoring sessions.
+
+A recording is an 8 byte file header followed by one frame per tick. A frame
+is a kind byte, a 4 byte little-endian payload size and the payload. Every
+kKeyframeInterval ticks, and at the start of every session, a keyframe holds
+the whole snapshot; the frames in between only hold zigzag varint
+differences to the previous frame, and process rows seen in the previous
+frame carry no strings. Keyframes are preceded by kSync so that a reader can
+find them from any offset, which is how seeking works without an index:
+a recording is never read as a whole, only the frames around the position
+being shown are touched.
+*/
+namespace Recording {
+constexpr char kFileHeader[8]{'M', 'O', 'N', 'R', 'E', 'C', '\0', '\1'};
+constexpr char kSync[8]{'\0', 'M', 'O', 'N', 'K', 'E', 'Y', '\0'};
+constexpr int kKeyframeInterval{30};
+
+// Appends snapshots to a recording
+class Writer {
+ public:
+  Writer() = default;
+  ~Writer();
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  bool Open(const std::string& path, std::string& error);
+  bool Append(const Snapshot& snapshot);
+
+ private:
+  std::FILE* file_{nullptr};
+  int since_keyframe_{0};
+  Snapshot previous_;
+  std::unordered_map<int, std::size_t> previous_rows_;
+  std::string frame_;
+};
+
+// Read-only view of a memory-mapped recording. Positions are byte offsets
+// of frames; a keyframe's position is that of its sync marker.
+class Reader {
+ public:
+  Reader() = default;
+  ~Reader();
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  bool Open(const std::string& path, std::string& error);
+  std::size_t Begin() const;
+  std::size_t End() const;
+  bool IsKeyframe(std::size_t position) const;
+  std::size_t NextKeyframe(std::size_t position) const;
+  std::size_t PreviousKeyframe(std::size_t position) const;
+  std::size_t KeyframeAt(long long time_ms) const;
+  long long Time(std::size_t position, long long previous_ms) const;
+  std::size_t Decode(std::size_t position, Snapshot& snapshot) const;
+
+ private:
+  const char* data_{nullptr};
+  std::size_t size_{0};
+  std::size_t end_{0};  // end of the last complete frame
+};
+
+bool Run(System& system, const std::string& path, int interval_ms, int count,
+         int n, std::string& error);
+};  // namespace Recording
+
+#endif
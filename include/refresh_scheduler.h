@@ -0,0 +1,36 @@
+#ifndef REFRESH_SCHEDULER_H
+#define REFRESH_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+Chooses the time between refreshes so that the monitor's own CPU time stays
+within a budget, a share of one core. After every refresh the CPU the whole
+process used since the previous one is smoothed into a cost per refresh,
+and the interval becomes cost / budget, bounded to a quarter and ten times
+the base interval. Huge hosts are refreshed less often and idle ones more
+often. A budget of 0 keeps the base interval.
+*/
+class RefreshScheduler {
+ public:
+  explicit RefreshScheduler(
+      std::chrono::milliseconds interval = std::chrono::seconds(1),
+      double budget = 0);
+
+  std::chrono::milliseconds Next();
+  std::chrono::milliseconds Interval() const;
+  std::chrono::milliseconds Shortest() const;
+  float Usage() const;
+
+ private:
+  std::chrono::milliseconds base_;
+  double budget_;
+  std::chrono::milliseconds interval_;
+  double cost_{-1};  // CPU seconds per refresh, smoothed
+  float usage_{0};   // share of a core over the last refresh
+  std::int64_t cpu_ns_{-1};
+  std::chrono::steady_clock::time_point time_;
+};
+
+#endif
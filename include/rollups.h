@@ -0,0 +1,75 @@
+#ifndef ROLLUPS_H
+#define ROLLUPS_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "proc_file.h"
+#include "process.h"
+#include "snapshot.h"
+
+/*
+CPU and memory of the process table rolled up by cgroup v2 and by user.
+A process is attached to its cgroup once, through a small integer id, so a
+tick only adds its numbers to those of its groups. Where the cgroup
+filesystem is mounted, a cgroup's CPU and memory come from its own cpu.stat
+and memory.current instead of the sum of its processes: two reads per group
+rather than one per process, and they also count the processes that came
+and went between ticks. The root group, whose cpu.stat covers the whole
+system, keeps the sums. Groups are kept while they have processes.
+*/
+class Rollups {
+ public:
+  int Cgroup(std::string_view path);
+
+  // Once per tick: Begin(), Add() for every process, then End(). Groups are
+  // measured only when every process of the table was added.
+  void Begin();
+  void Add(int cgroup, int uid, float cpu, long ram_kb);
+  std::size_t End(bool measure);
+  bool Live(int cgroup) const;
+
+  void Fill(SortKey key, std::size_t n, std::vector<GroupRow>& cgroups,
+            std::vector<GroupRow>& users);
+
+ private:
+  struct Totals {
+    int processes{0};
+    float cpu{0};
+    long ram_kb{0};
+  };
+
+  struct Group {
+    std::string path;
+    Totals totals;
+    // Files of the cgroup, dropped if they cannot be opened
+    std::unique_ptr<ProcFile> cpu_stat;
+    std::unique_ptr<ProcFile> memory;
+    long long usage_usec{-1};
+    std::chrono::steady_clock::time_point read;
+  };
+
+  // A group as ranked by Fill(), which copies only the rows it keeps
+  struct Ranked {
+    std::string_view name;
+    int processes;
+    float cpu;
+    long ram_kb;
+  };
+
+  void Measure(Group& group);
+
+  std::vector<Group> cgroups_;
+  std::vector<int> free_;
+  std::unordered_map<std::string, int> ids_;
+  std::string key_;  // reused to look paths up in ids_
+  std::vector<Ranked> ranked_;
+  std::unordered_map<int, Totals> users_;
+};
+
+#endif
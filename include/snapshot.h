@@ -0,0 +1,99 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "instrumentation.h"
+#include "process.h"
+
+// One row of the process list, with every field already resolved
+struct ProcessRow {
+  int pid{0};
+  int uid{-1};
+  std::string user;
+  std::string command;
+  float cpu{0};
+  long ram_kb{0};
+  // Shown but not recorded; -1 when unknown
+  long pss_kb{-1};
+  long swap_kb{-1};
+  float read_rate{-1};   // bytes per second
+  float write_rate{-1};  // bytes per second
+  float major_fault_rate{0};
+  long uptime{0};
+  // Fixed-point history, oldest first; see History
+  std::vector<std::uint16_t> cpu_history;
+  std::vector<std::uint32_t> rss_history;
+};
+
+// One thread of the process whose threads are shown
+struct ThreadRow {
+  int tid{0};
+  std::string name;
+  char state{'?'};
+  float cpu{0};
+  long uptime{0};
+};
+
+// Totals of a group of processes: a cgroup or the processes of a user
+struct GroupRow {
+  std::string name;
+  int processes{0};
+  float cpu{0};
+  long ram_kb{0};
+};
+
+/*
+Everything a front end shows for one tick. A snapshot is plain data,
+detached from /proc, so it can be handed from the collector thread to the
+renderer. Vectors and strings are reused when a snapshot is refilled.
+*/
+struct Snapshot {
+  unsigned long sequence{0};
+  // Set by the collector: the time until the next refresh and the share of
+  // a core the monitor itself used over the last one
+  long interval_ms{0};
+  float self_cpu{0};
+  long long time_ms{0};  // wall clock, milliseconds since the epoch
+  std::string operating_system;
+  std::string kernel;
+  float cpu{0};
+  std::vector<float> cores;
+  float memory{0};
+  LinuxParser::MemInfo meminfo;
+  // Paging from /proc/vmstat, per second
+  float page_faults{0};
+  float major_faults{0};
+  float swap_ins{0};
+  float swap_outs{0};
+  bool has_pressure{false};
+  LinuxParser::Pressure pressure[LinuxParser::kPressureResources];
+  long uptime{0};
+  float load_average[3]{};
+  int total_processes{0};  // forks since boot, from /proc/stat
+  int running_processes{0};
+  std::size_t live_processes{0};  // in the process table; 0 in replays
+  SortKey sort_key{SortKey::kCpu};
+  // Text of the process filter, empty when none is set, and how many
+  // processes it matched
+  std::string filter;
+  std::size_t matches{0};
+  std::vector<ProcessRow> processes;
+  // Threads of process threads_pid, busiest first; -1 when none is expanded
+  int threads_pid{-1};
+  std::vector<ThreadRow> threads;
+  std::vector<GroupRow> cgroups;
+  std::vector<GroupRow> users;
+  // Fixed-point history, oldest first, of at most history_length samples:
+  // what the history window holds at the current pace
+  std::size_t history_length{0};
+  std::vector<std::uint16_t> cpu_history;
+  std::vector<std::uint16_t> memory_history;
+  std::vector<std::vector<std::uint16_t>> core_history;
+  Instrumentation::Tick cost;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SNAPSHOT_SOURCE_H
+#define SNAPSHOT_SOURCE_H
+
+#include <string>
+
+#include "filter.h"
+#include "process.h"
+#include "snapshot.h"
+
+// Where the display takes its snapshots from: live collection or a replay
+class SnapshotSource {
+ public:
+  virtual ~SnapshotSource() = default;
+
+  // Make the newest snapshot current. Returns false if there is nothing
+  // newer than Current().
+  virtual bool Update() = 0;
+  virtual const Snapshot& Current() const = 0;
+  virtual void SortBy(SortKey key) = 0;
+  // Collect the threads of one process from now on, or of none with -1
+  virtual void ShowThreads(int /*pid*/) {}
+  // Read the files in sources per process from now on; see Columns::Source
+  virtual void Collect(unsigned /*sources*/) {}
+  // Show only the processes filter matches; false if the source cannot
+  virtual bool SetFilter(const Filter& /*filter*/) { return false; }
+
+  // Keys the source handles itself, such as replay controls
+  virtual bool HandleKey(int /*key*/) { return false; }
+  // One line about the source, shown in the display; empty for live data
+  virtual std::string Status() const { return {}; }
+};
+
+#endif
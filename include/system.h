@@ -1,18 +1,50 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <chrono>
+#include <memory_resource>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "columns.h"
+#include "filter.h"
+#include "history.h"
+#include "instrumentation.h"
+#include "linux_parser.h"
 #include "process.h"
+#include "process_discovery.h"
 #include "processor.h"
+#include "rollups.h"
+#include "snapshot.h"
+#include "tick_arena.h"
+#include "worker_pool.h"
 
 class System {
  public:
+  using SortKey = ::SortKey;
+
+  explicit System(int workers = 1, ProcessDiscovery::Backend discovery =
+                                        ProcessDiscovery::Backend::kScan);
+  void Refresh();
+  void SortBy(SortKey key);
+  SortKey SortedBy() const;
+  void TopN(int n);
+  void KeepHistory(std::chrono::milliseconds window,
+                   std::chrono::milliseconds interval);
+  void ShowThreads(int pid);
+  int ThreadsShown() const;
+  void SetFilter(const Filter& filter);
+  void Collect(unsigned sources);
+  unsigned Collected() const;
+  ProcessDiscovery::Backend Discovery() const;
   Processor& Cpu();                   // TODO: See src/system.cpp
   std::vector<Process>& Processes();  // TODO: See src/system.cpp
   float MemoryUtilization();          // TODO: See src/system.cpp
   long UpTime();                      // TODO: See src/system.cpp
+  const float* LoadAverage() const;
+  const Instrumentation::Tick& Cost() const;
+  void TakeSnapshot(Snapshot& snapshot);
   int TotalProcesses();               // TODO: See src/system.cpp
   int RunningProcesses();             // TODO: See src/system.cpp
   std::string Kernel();               // TODO: See src/system.cpp
@@ -20,8 +52,90 @@ class System {
 
  // Define any necessary private members
  private:
+  // Entry of the persistent process table, stamped with the last refresh
+  // that saw its PID
+  struct Entry {
+    Process process;
+    unsigned long last_seen;
+    int cgroup{-1};  // see Rollups
+    bool cgroup_read{false};
+    unsigned long details_read{0};
+    bool exec{false};  // reported by the discovery backend
+    Filter::Match match{Filter::Match::kYes};
+  };
+
+  // Entry of the thread table of the process whose threads are shown
+  struct Thread {
+    Process process;
+    char state;
+    std::string name;
+    unsigned long last_seen;
+  };
+
+  // Records read by one worker for one PID. Its strings live in the
+  // worker's arena until the next refresh.
+  struct Sample {
+    explicit Sample(std::pmr::memory_resource* arena)
+        : cgroup(arena), command(arena) {}
+
+    LinuxParser::ProcStat stat;
+    LinuxParser::ProcStatus status;
+    bool has_status{false};
+    bool exec{false};
+    bool cgroup_read{false};
+    bool has_cgroup{false};
+    std::pmr::string cgroup;
+    Filter::Match match{Filter::Match::kYes};
+    bool has_command{false};
+    std::pmr::string command;
+  };
+
+  void UpdateProcesses(long system_jiffies);
+  void Merge(const Sample& sample, long system_jiffies);
+  Filter::Match Screen(const Process& process) const;
+  unsigned Needed() const;
+  void Select();
+  void ReadDetails();
+  void Rollup();
+  void UpdateThreads();
+  void UpdatePaging();
+  void RecordHistory();
+  bool Before(const Process& a, const Process& b) const;
+
   Processor cpu_ = {};
+  LinuxParser::StatSnapshot stat_ = {};
+  float memory_utilization_{0};
+  LinuxParser::MemInfo meminfo_ = {};
+  LinuxParser::VmStat vmstat_ = {};
+  std::chrono::steady_clock::time_point vmstat_time_;
+  float paging_rates_[4]{};  // faults, major faults, swap ins, swap outs
+  bool has_pressure_{false};
+  LinuxParser::Pressure pressure_[LinuxParser::kPressureResources] = {};
+  long up_time_{0};
+  float load_average_[3]{};
+  Instrumentation::Tick cost_ = {};
+  std::string operating_system_;
+  std::string kernel_;
   std::vector<Process> processes_ = {};
+  std::unordered_map<int, Entry> table_ = {};
+  unsigned long refresh_count_{0};
+  ProcessDiscovery discovery_;
+  WorkerPool pool_;
+  std::vector<std::vector<Sample>> samples_;
+  std::vector<TickArena> arenas_;  // one per worker
+  SortKey sort_key_{SortKey::kCpu};
+  std::size_t top_n_{10};
+  Filter filter_;
+  unsigned sources_{Columns::kAllSources};  // see Columns::Source
+  std::vector<const Process*> candidates_ = {};
+  std::unordered_map<int, int> user_rank_ = {};
+  History history_;
+  Rollups rollups_;
+  int threads_pid_{-1};
+  long system_jiffies_{0};
+  std::vector<int> tids_ = {};
+  std::unordered_map<int, Thread> threads_ = {};
+  std::vector<const Thread*> thread_order_ = {};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef TICK_ARENA_H
+#define TICK_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+/*
+Memory for what lives during one refresh only, such as the strings the
+workers read per process. Allocating bumps a pointer through one buffer and
+Reset() releases everything at once. A refresh that outgrows the buffer
+takes the rest from the heap, and the next Reset() grows the buffer to fit,
+so a refresh in steady state makes no heap allocation.
+Not thread safe: each worker has its own.
+*/
+class TickArena {
+ public:
+  TickArena();
+  TickArena(const TickArena&) = delete;
+  TickArena& operator=(const TickArena&) = delete;
+
+  std::pmr::memory_resource* Resource();
+  void Reset();
+
+ private:
+  // Heap memory taken once the buffer is used up, counted to size the next
+  // buffer
+  class Overflow : public std::pmr::memory_resource {
+   public:
+    std::size_t bytes{0};
+
+   private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes,
+                       std::size_t alignment) override;
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+  };
+
+  std::vector<std::byte> buffer_;
+  Overflow overflow_;
+  std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+#endif
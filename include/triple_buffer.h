@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*
+Lock-free triple buffer between one producer and one consumer.
+The producer fills Back() and publishes it; the consumer picks up the most
+recently published value with Update() and reads it through Front(). Neither
+side ever waits for the other, and a slow consumer simply skips values.
+*/
+template <typename T>
+class TripleBuffer {
+ public:
+  // Producer side
+  T& Back() { return buffers_[back_]; }
+
+  void Publish() {
+    back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+            kIndexMask;
+  }
+
+  // Consumer side: returns true if a newer value became the front
+  bool Update() {
+    if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  const T& Front() const { return buffers_[front_]; }
+
+ private:
+  static constexpr int kIndexMask{3};
+  static constexpr int kFresh{4};
+
+  T buffers_[3];
+  int back_{0};
+  std::atomic<int> middle_{1};
+  int front_{2};
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include <time.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "proc_file.h"
+
+/*
+Samples a few pinned processes at a high rate, every 10 to 100 ms, without
+walking /proc. Each process keeps its stat open and re-reads it with pread,
+and its CPU time comes from its CPU-time clock: two syscalls per process per
+sample. The clock counts every thread in nanoseconds, where stat counts
+whole jiffies that are too coarse at these intervals; stat is the fallback
+when the clock is unavailable or the proc root is not the real /proc.
+A process that exits, or whose PID is reused, is reported once and then
+dropped.
+*/
+class Watcher {
+ public:
+  // One reading of one process; rates cover the time since the previous one
+  struct Sample {
+    int pid{0};
+    bool exited{false};
+    char state{'?'};
+    float cpu{0};  // share of one core
+    long ram_kb{0};
+    float major_fault_rate{0};  // per second
+  };
+
+  explicit Watcher(const std::vector<int>& pids);
+  bool Read(std::vector<Sample>& samples);
+
+ private:
+  struct Watched {
+    int pid{0};
+    std::unique_ptr<ProcFile> stat;
+    clockid_t clock{0};
+    bool has_clock{false};
+    long start_time{-1};
+    long run_ns{-1};
+    long jiffies{0};
+    long majflt{0};
+    std::chrono::steady_clock::time_point time;
+  };
+
+  std::vector<Watched> watched_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Fixed pool of worker threads for index-partitioned jobs.
+The index range of a job is split into one shard per worker. A worker claims
+small chunks of its own shard and, once that is exhausted, steals chunks from
+the other shards, so a few slow indices do not stall the whole job.
+The calling thread takes part as worker 0, so a pool of size 1 runs every
+job inline without any threads.
+*/
+class WorkerPool {
+ public:
+  // Reference to a callable taking (int worker, std::size_t index). Unlike
+  // std::function it does not own the callable, so passing a lambda to Run()
+  // never allocates.
+  class Job {
+   public:
+    // Implicit, so that a lambda can be passed straight to Run()
+    template <typename Function>
+    Job(const Function& function)
+        : function_(&function),
+          call_([](const void* function, int worker, std::size_t index) {
+            (*static_cast<const Function*>(function))(worker, index);
+          }) {}
+
+    void operator()(int worker, std::size_t index) const {
+      call_(function_, worker, index);
+    }
+
+   private:
+    const void* function_;
+    void (*call_)(const void*, int, std::size_t);
+  };
+
+  explicit WorkerPool(int workers = 1);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  int Size() const;
+  void Run(std::size_t count, const Job& job);
+
+ private:
+  // Range of indices owned by one worker; next is claimed atomically
+  struct Shard {
+    std::atomic<std::size_t> next{0};
+    std::size_t end{0};
+  };
+
+  void Work(int worker);
+  void Loop(int worker);
+  bool Claim(Shard& shard, std::size_t& begin, std::size_t& end);
+
+  std::unique_ptr<Shard[]> shards_;
+  std::vector<std::thread> threads_;
+  const Job* job_{nullptr};
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  unsigned long generation_{0};
+  int running_{0};
+  bool stop_{false};
+  int size_;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "collector.h"
+
+#include <utility>
+
+// Start collecting right away; the first snapshot is published after the
+// first refresh
+Collector::Collector(System& system, RefreshScheduler scheduler)
+    : system_(system),
+      scheduler_(scheduler),
+      sort_key_(system.SortedBy()),
+      threads_pid_(system.ThreadsShown()),
+      sources_(system.Collected()),
+      thread_(&Collector::Loop, this) {}
+
+Collector::~Collector() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+// Make the most recently published snapshot current. Returns false if there
+// is nothing newer than Current().
+bool Collector::Update() { return snapshots_.Update(); }
+
+const Snapshot& Collector::Current() const { return snapshots_.Front(); }
+
+// Re-sort the process list. The collector applies it to the latest sample
+// and publishes a new snapshot without waiting for the next refresh.
+void Collector::SortBy(SortKey key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sort_key_.store(key);
+  }
+  wake_.notify_one();
+}
+
+// Collect the threads of one process, published as soon as they are read
+void Collector::ShowThreads(int pid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_pid_.store(pid);
+  }
+  wake_.notify_one();
+}
+
+// Change the files read per process; details newly needed are read for the
+// processes shown straight away, the rest at the next refresh
+void Collector::Collect(unsigned sources) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sources_.store(sources);
+  }
+  wake_.notify_one();
+}
+
+// Filter the process list. Like a new sort order it is applied to the latest
+// sample straight away.
+bool Collector::SetFilter(const Filter& filter) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    filter_ = filter;
+    filter_changed_ = true;
+  }
+  wake_.notify_one();
+  return true;
+}
+
+// Whether a request is waiting to be applied to the latest sample. Called
+// with mutex_ held, under which requests are stored so that none lands
+// between this check and the wait.
+bool Collector::Changed() const {
+  return sort_key_.load() != system_.SortedBy() ||
+         threads_pid_.load() != system_.ThreadsShown() ||
+         sources_.load() != system_.Collected() || filter_changed_;
+}
+
+// Apply the waiting requests to the system
+void Collector::Apply() {
+  Filter filter;
+  bool filter_changed{false};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(filter_changed, filter_changed_);
+    if (filter_changed) {
+      filter = filter_;
+    }
+  }
+  if (filter_changed) {
+    system_.SetFilter(filter);
+  }
+  if (sort_key_.load() != system_.SortedBy()) {
+    system_.SortBy(sort_key_.load());
+  }
+  if (threads_pid_.load() != system_.ThreadsShown()) {
+    system_.ShowThreads(threads_pid_.load());
+  }
+  if (sources_.load() != system_.Collected()) {
+    system_.Collect(sources_.load());
+  }
+}
+
+// Body of the collector thread
+void Collector::Loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    lock.unlock();
+    Apply();
+    system_.Refresh();
+    scheduler_.Next();
+    Publish();
+    lock.lock();
+
+    const auto next =
+        std::chrono::steady_clock::now() + scheduler_.Interval();
+    while (!stop_ && std::chrono::steady_clock::now() < next) {
+      wake_.wait_until(lock, next, [this] { return stop_ || Changed(); });
+      if (!stop_ && Changed()) {
+        lock.unlock();
+        Apply();
+        Publish();
+        lock.lock();
+      }
+    }
+  }
+}
+
+void Collector::Publish() {
+  Snapshot& snapshot = snapshots_.Back();
+  system_.TakeSnapshot(snapshot);
+  snapshot.sequence = ++sequence_;
+  snapshot.interval_ms = scheduler_.Interval().count();
+  snapshot.self_cpu = scheduler_.Usage();
+  snapshots_.Publish();
+}
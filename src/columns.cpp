@@ -0,0 +1,94 @@
+#include "columns.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+// In the order of Columns::Id, which is also the default layout
+const Columns::Column kColumns[]{
+    {Columns::Id::kPid, "pid", "PID", 7, Columns::kStat, true, SortKey::kPid},
+    {Columns::Id::kUser, "user", "USER", 9, Columns::kStatus, true,
+     SortKey::kUser},
+    {Columns::Id::kCpu, "cpu", "CPU[%]", 8, Columns::kStat, true,
+     SortKey::kCpu},
+    {Columns::Id::kRam, "ram", "RAM[MB]", 8, Columns::kStat, true,
+     SortKey::kRam},
+    {Columns::Id::kPss, "pss", "PSS[MB]", 8, Columns::kSmapsRollup, false,
+     SortKey::kCpu},
+    {Columns::Id::kSwap, "swap", "SWP[MB]", 8, Columns::kSmapsRollup, false,
+     SortKey::kCpu},
+    {Columns::Id::kRead, "read", "READ/s", 7, Columns::kIo, false,
+     SortKey::kCpu},
+    {Columns::Id::kWrite, "write", "WRITE/s", 8, Columns::kIo, false,
+     SortKey::kCpu},
+    {Columns::Id::kFaults, "faults", "FLT/s", 6, Columns::kStat, false,
+     SortKey::kCpu},
+    {Columns::Id::kTime, "time", "TIME+", 11, Columns::kStat, true,
+     SortKey::kUpTime},
+    {Columns::Id::kCommand, "command", "COMMAND", 7, Columns::kCmdline, false,
+     SortKey::kCpu},
+};
+}  // namespace
+
+// Return the registry entry of a column
+const Columns::Column& Columns::Get(Id id) {
+  return kColumns[static_cast<int>(id)];
+}
+
+// Return every column, in registry order
+const vector<Columns::Id>& Columns::Defaults() {
+  static const vector<Id> defaults = [] {
+    vector<Id> ids;
+    for (const auto& column : kColumns) {
+      ids.push_back(column.id);
+    }
+    return ids;
+  }();
+  return defaults;
+}
+
+// Parse a comma-separated list of column names, in display order
+bool Columns::Parse(const string& names, vector<Id>& columns, string& error) {
+  vector<Id> parsed;
+  string::size_type start{0};
+  while (start <= names.size()) {
+    auto end = names.find(',', start);
+    if (end == string::npos) {
+      end = names.size();
+    }
+    const string name = names.substr(start, end - start);
+    bool found{false};
+    for (const auto& column : kColumns) {
+      if (name == column.name) {
+        parsed.push_back(column.id);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      error = name.empty() ? "empty column name" : "unknown column: " + name;
+      return false;
+    }
+    start = end + 1;
+  }
+  columns = std::move(parsed);
+  return true;
+}
+
+// Return the files the columns are computed from
+unsigned Columns::Sources(const vector<Id>& columns) {
+  unsigned sources{kStat};
+  for (const Id id : columns) {
+    sources |= Get(id).sources;
+  }
+  return sources;
+}
+
+// Return the files sorting by key needs, shown or not
+unsigned Columns::Sources(SortKey key) {
+  return key == SortKey::kUser ? kStat | kStatus : kStat;
+}
@@ -0,0 +1,233 @@
+#include "command_line.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+
+namespace {
+// Upper bound of the default worker count; /proc reads stop scaling well
+// beyond this
+constexpr int kMaxDefaultThreads{8};
+
+// Upper bound of --history, which keeps the history buffers to a few MB
+constexpr int kMaxHistoryMinutes{60};
+
+// Upper bound of the processes --watch samples
+constexpr std::size_t kMaxWatched{16};
+
+// Default time between --watch samples, in ms, unless --interval is given
+constexpr int kWatchInterval{50};
+
+// Parse the integer value of --name=value, rejecting trailing garbage and
+// anything an int cannot hold
+bool ParseInt(const string& value, int minimum, int& result) {
+  char* end = nullptr;
+  errno = 0;
+  const long parsed = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || errno == ERANGE || parsed < minimum ||
+      parsed > INT_MAX) {
+    return false;
+  }
+  result = static_cast<int>(parsed);
+  return true;
+}
+
+// Whether the value of an option may also be given as the next argument,
+// as in --record file or --listen :9100
+bool TakesNextArgument(const string& name) {
+  return name == "--record" || name == "--replay" || name == "--listen";
+}
+
+// Parse a comma-separated list of PIDs
+bool ParsePids(const string& value, std::vector<int>& pids) {
+  pids.clear();
+  string::size_type start{0};
+  while (start <= value.size()) {
+    auto end = value.find(',', start);
+    if (end == string::npos) {
+      end = value.size();
+    }
+    int pid{0};
+    if (!ParseInt(value.substr(start, end - start), 1, pid)) {
+      return false;
+    }
+    pids.push_back(pid);
+    start = end + 1;
+  }
+  return true;
+}
+}  // namespace
+
+// One thread per core up to a small limit; tiny hosts collect on the main
+// thread only
+int CommandLine::Options::DefaultThreads() {
+  const int cores = static_cast<int>(std::thread::hardware_concurrency());
+  return cores <= 2 ? 1 : std::min(cores, kMaxDefaultThreads);
+}
+
+// Fill options from the arguments, returning false with a message in error
+// for anything that is not understood
+bool CommandLine::Parse(int argc, char* argv[], Options& options,
+                        string& error) {
+  bool interval_given{false};
+  for (int i = 1; i < argc; ++i) {
+    const string argument{argv[i]};
+    const auto equals = argument.find('=');
+    const string name = argument.substr(0, equals);
+    string value =
+        equals == string::npos ? string() : argument.substr(equals + 1);
+    if (equals == string::npos && TakesNextArgument(name) && i + 1 < argc) {
+      value = argv[++i];
+    }
+    if (name == "--threads") {
+      if (!ParseInt(value, 1, options.threads)) {
+        error = "invalid thread count: " + value;
+        return false;
+      }
+    } else if (name == "--top") {
+      if (!ParseInt(value, 1, options.top)) {
+        error = "invalid process count: " + value;
+        return false;
+      }
+    } else if (name == "--batch") {
+      options.batch = true;
+    } else if (name == "--interval") {
+      if (!ParseInt(value, 1, options.interval_ms)) {
+        error = "invalid interval: " + value;
+        return false;
+      }
+      interval_given = true;
+    } else if (name == "--count") {
+      if (!ParseInt(value, 0, options.count)) {
+        error = "invalid count: " + value;
+        return false;
+      }
+    } else if (name == "--format") {
+      if (value != "ndjson") {
+        error = "unsupported format: " + value;
+        return false;
+      }
+      options.format = value;
+    } else if (name == "--discovery") {
+      if (value != "scan" && value != "netlink") {
+        error = "unsupported discovery backend: " + value;
+        return false;
+      }
+      options.netlink = value == "netlink";
+    } else if (name == "--self-stats") {
+      options.self_stats = true;
+    } else if (name == "--groups") {
+      options.groups = true;
+    } else if (name == "--history") {
+      if (!ParseInt(value, 1, options.history_minutes) ||
+          options.history_minutes > kMaxHistoryMinutes) {
+        error = "invalid history length: " + value;
+        return false;
+      }
+    } else if (name == "--record" || name == "--replay") {
+      if (value.empty()) {
+        error = "missing file for " + name;
+        return false;
+      }
+      (name == "--record" ? options.record : options.replay) = value;
+    } else if (name == "--columns") {
+      if (!Columns::Parse(value, options.columns, error)) {
+        return false;
+      }
+    } else if (name == "--budget") {
+      char* end = nullptr;
+      options.budget_percent = std::strtod(value.c_str(), &end);
+      if (value.empty() || *end != '\0' || options.budget_percent < 0 ||
+          options.budget_percent > 100) {
+        error = "invalid CPU budget: " + value;
+        return false;
+      }
+    } else if (name == "--watch") {
+      if (!ParsePids(value, options.watch) ||
+          options.watch.size() > kMaxWatched) {
+        error = "invalid PID list: " + value;
+        return false;
+      }
+    } else if (name == "--listen") {
+      if (value.empty()) {
+        error = "missing address for --listen";
+        return false;
+      }
+      options.listen = value;
+    } else if (name == "--filter") {
+      options.filter = value;
+    } else if (name == "--proc-root") {
+      if (value.empty()) {
+        error = "missing directory for --proc-root";
+        return false;
+      }
+      options.proc_root = value;
+    } else {
+      error = "unknown option: " + argument;
+      return false;
+    }
+  }
+  if (options.batch + !options.record.empty() + !options.replay.empty() +
+          !options.watch.empty() + !options.listen.empty() >
+      1) {
+    error =
+        "--batch, --record, --replay, --watch and --listen cannot be combined";
+    return false;
+  }
+  if (!options.watch.empty() && !interval_given) {
+    options.interval_ms = kWatchInterval;
+  }
+  if (!options.filter.empty() && !options.replay.empty()) {
+    error = "--filter applies to live data only";
+    return false;
+  }
+  return true;
+}
+
+// Return the help text
+string CommandLine::Usage() {
+  return "usage: monitor [options]\n"
+         "  --threads=<n>     number of threads reading /proc (1 = no "
+         "workers)\n"
+         "  --top=<n>         number of processes shown (default 10)\n"
+         "  --batch           write records to stdout instead of drawing\n"
+         "  --interval=<ms>   time between ticks (default 1000); the "
+         "display adapts it\n"
+         "                    to --budget\n"
+         "  --budget=<pct>    CPU share of one core the display may use, 0 = "
+         "fixed\n"
+         "                    interval (default 1)\n"
+         "  --count=<n>       number of batch or recorded ticks, 0 = forever "
+         "(default 0)\n"
+         "  --format=ndjson   batch record format\n"
+         "  --self-stats      add the monitor's own cost to batch records\n"
+         "  --groups          add cgroup and user totals to batch records\n"
+         "  --record=<file>   append a binary recording to file instead of "
+         "drawing;\n"
+         "                    also --record <file>\n"
+         "  --replay=<file>   play a recording back; also --replay <file>\n"
+         "  --watch=<pids>    sample up to 16 PIDs every --interval (default "
+         "50) as\n"
+         "                    JSON lines\n"
+         "  --listen=<addr>   serve OpenMetrics at http://addr/metrics instead "
+         "of\n"
+         "                    drawing, e.g. :9100 or 127.0.0.1:9100; also "
+         "--listen <addr>\n"
+         "  --history=<min>   minutes of history kept, up to 60 (default 5)\n"
+         "  --columns=<list>  process columns shown, e.g. pid,cpu,command; "
+         "only\n"
+         "                    their files are read (default all)\n"
+         "  --filter=<expr>   show only the processes expr matches, e.g.\n"
+         "                    'user==postgres && cpu>5 && cmd~worker'\n"
+         "  --discovery=scan|netlink\n"
+         "                    find processes by scanning /proc (default) or "
+         "from\n"
+         "                    proc connector events\n"
+         "  --proc-root=<dir> read processes from dir instead of /proc\n";
+}
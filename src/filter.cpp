@@ -0,0 +1,438 @@
+#include "filter.h"
+
+#include <pwd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::string;
+using Cost = Filter::Cost;
+using Match = Filter::Match;
+
+enum class Field { kPid, kPpid, kState, kComm, kRam, kTime, kUid, kCmd, kCpu };
+enum class Op { kEq, kNe, kLt, kLe, kGt, kGe, kMatch, kNoMatch };
+
+// One node of the compiled expression tree
+struct Filter::Node {
+  enum class Kind { kAnd, kOr, kNot, kCompare };
+  Kind kind{Kind::kCompare};
+  Cost cost{Cost::kFree};  // most expensive field below this node
+  std::vector<std::unique_ptr<Node>> children;
+  Field field{Field::kPid};
+  Op op{Op::kEq};
+  double number{0};
+  string text;
+  std::regex regex;
+};
+
+using Node = Filter::Node;
+
+namespace {
+struct FieldInfo {
+  const char* name;
+  Field field;
+  Cost cost;
+  bool numeric;
+};
+
+// user compiles to a comparison of uid, by name
+constexpr FieldInfo kFields[]{
+    {"pid", Field::kPid, Cost::kFree, true},
+    {"ppid", Field::kPpid, Cost::kStat, true},
+    {"state", Field::kState, Cost::kStat, false},
+    {"comm", Field::kComm, Cost::kStat, false},
+    {"ram", Field::kRam, Cost::kStat, true},
+    {"time", Field::kTime, Cost::kStat, true},
+    {"uid", Field::kUid, Cost::kStatus, true},
+    {"user", Field::kUid, Cost::kStatus, false},
+    {"cmd", Field::kCmd, Cost::kCmdline, false},
+    {"cpu", Field::kCpu, Cost::kUsage, true},
+};
+
+// Recursive descent over
+//   or      := and ('||' and)*
+//   and     := unary ('&&' unary)*
+//   unary   := '!' unary | '(' or ')' | field op value
+class Parser {
+ public:
+  explicit Parser(const string& text) : text_(text) {}
+
+  std::unique_ptr<Node> Parse(string& error) {
+    auto node = Or();
+    Skip();
+    if (node && position_ < text_.size()) {
+      Fail("unexpected '" + text_.substr(position_) + "'");
+    }
+    if (!error_.empty()) {
+      error = error_;
+      return nullptr;
+    }
+    return node;
+  }
+
+ private:
+  void Skip() {
+    while (position_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[position_]))) {
+      ++position_;
+    }
+  }
+
+  bool Accept(const char* token) {
+    Skip();
+    const std::string_view rest{text_.data() + position_,
+                                text_.size() - position_};
+    const std::string_view wanted{token};
+    if (rest.substr(0, wanted.size()) != wanted) {
+      return false;
+    }
+    position_ += wanted.size();
+    return true;
+  }
+
+  std::unique_ptr<Node> Fail(const string& message) {
+    if (error_.empty()) {
+      error_ = message;
+    }
+    return nullptr;
+  }
+
+  // Joins operands of one kind, keeping the cheapest first so evaluation
+  // stops before the expensive fields are needed
+  static std::unique_ptr<Node> Join(Node::Kind kind,
+                                    std::vector<std::unique_ptr<Node>> nodes) {
+    if (nodes.size() == 1) {
+      return std::move(nodes.front());
+    }
+    auto node = std::make_unique<Node>();
+    node->kind = kind;
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [](const auto& a, const auto& b) {
+                       return a->cost < b->cost;
+                     });
+    node->cost = nodes.back()->cost;
+    node->children = std::move(nodes);
+    return node;
+  }
+
+  std::unique_ptr<Node> Or() {
+    std::vector<std::unique_ptr<Node>> nodes;
+    do {
+      auto node = And();
+      if (!node) {
+        return nullptr;
+      }
+      nodes.push_back(std::move(node));
+    } while (Accept("||"));
+    return Join(Node::Kind::kOr, std::move(nodes));
+  }
+
+  std::unique_ptr<Node> And() {
+    std::vector<std::unique_ptr<Node>> nodes;
+    do {
+      auto node = Unary();
+      if (!node) {
+        return nullptr;
+      }
+      nodes.push_back(std::move(node));
+    } while (Accept("&&"));
+    return Join(Node::Kind::kAnd, std::move(nodes));
+  }
+
+  std::unique_ptr<Node> Unary() {
+    if (Accept("!")) {
+      auto operand = Unary();
+      if (!operand) {
+        return nullptr;
+      }
+      auto node = std::make_unique<Node>();
+      node->kind = Node::Kind::kNot;
+      node->cost = operand->cost;
+      node->children.push_back(std::move(operand));
+      return node;
+    }
+    if (Accept("(")) {
+      auto node = Or();
+      if (node && !Accept(")")) {
+        return Fail("missing ')'");
+      }
+      return node;
+    }
+    return Compare();
+  }
+
+  // A field name, or a bare value made of anything but operators and blanks
+  string Word() {
+    Skip();
+    const auto start = position_;
+    while (position_ < text_.size() &&
+           (std::isalnum(static_cast<unsigned char>(text_[position_])) ||
+            string("_.-:/@+").find(text_[position_]) != string::npos)) {
+      ++position_;
+    }
+    return text_.substr(start, position_ - start);
+  }
+
+  bool Value(string& value) {
+    Skip();
+    if (position_ < text_.size() && text_[position_] == '"') {
+      for (++position_; position_ < text_.size(); ++position_) {
+        char c = text_[position_];
+        if (c == '"') {
+          ++position_;
+          return true;
+        }
+        if (c == '\\' && position_ + 1 < text_.size()) {
+          c = text_[++position_];
+        }
+        value += c;
+      }
+      Fail("unterminated string");
+      return false;
+    }
+    value = Word();
+    if (value.empty()) {
+      Fail("missing value");
+      return false;
+    }
+    return true;
+  }
+
+  std::unique_ptr<Node> Compare() {
+    const string name = Word();
+    if (name.empty()) {
+      return Fail(position_ < text_.size()
+                      ? "unexpected '" + text_.substr(position_) + "'"
+                      : "missing comparison");
+    }
+    const auto info = std::find_if(
+        std::begin(kFields), std::end(kFields),
+        [&name](const FieldInfo& field) { return name == field.name; });
+    if (info == std::end(kFields)) {
+      return Fail("unknown field: " + name);
+    }
+    auto node = std::make_unique<Node>();
+    node->field = info->field;
+    node->cost = info->cost;
+    // Longest operators first
+    if (Accept("==")) {
+      node->op = Op::kEq;
+    } else if (Accept("!=")) {
+      node->op = Op::kNe;
+    } else if (Accept("!~")) {
+      node->op = Op::kNoMatch;
+    } else if (Accept("<=")) {
+      node->op = Op::kLe;
+    } else if (Accept(">=")) {
+      node->op = Op::kGe;
+    } else if (Accept("<")) {
+      node->op = Op::kLt;
+    } else if (Accept(">")) {
+      node->op = Op::kGt;
+    } else if (Accept("~")) {
+      node->op = Op::kMatch;
+    } else {
+      return Fail("missing operator after " + name);
+    }
+    const bool matches = node->op == Op::kMatch || node->op == Op::kNoMatch;
+    const bool ordered = !matches && node->op != Op::kEq && node->op != Op::kNe;
+    string value;
+    if (!Value(value)) {
+      return nullptr;
+    }
+    if (info->numeric) {
+      if (matches) {
+        return Fail(name + " is a number and cannot be matched with ~");
+      }
+      char* end = nullptr;
+      node->number = std::strtod(value.c_str(), &end);
+      if (*end != '\0') {
+        return Fail("invalid number: " + value);
+      }
+    } else if (matches) {
+      try {
+        node->regex = std::regex(value, std::regex::optimize);
+      } catch (const std::regex_error&) {
+        return Fail("invalid pattern: " + value);
+      }
+      node->text = value;
+    } else if (ordered) {
+      return Fail(name + " is text and cannot be compared with < or >");
+    } else if (info->field == Field::kUid) {
+      // Resolve the name once here rather than for every process
+      struct passwd entry;
+      struct passwd* result = nullptr;
+      char buffer[1024];
+      if (getpwnam_r(value.c_str(), &entry, buffer, sizeof(buffer), &result) !=
+              0 ||
+          result == nullptr) {
+        return Fail("unknown user: " + value);
+      }
+      node->number = result->pw_uid;
+    } else {
+      node->text = value;
+    }
+    return node;
+  }
+
+  const string& text_;
+  string::size_type position_{0};
+  string error_;
+};
+
+template <typename T>
+bool Compare(Op op, const T& a, const T& b) {
+  switch (op) {
+    case Op::kEq:
+      return a == b;
+    case Op::kNe:
+      return a != b;
+    case Op::kLt:
+      return a < b;
+    case Op::kLe:
+      return a <= b;
+    case Op::kGt:
+      return a > b;
+    case Op::kGe:
+      return a >= b;
+    default:
+      return false;
+  }
+}
+
+Match Known(bool value) { return value ? Match::kYes : Match::kNo; }
+
+// A text comparison, or a regular expression search for ~ and !~
+Match CompareText(const Node& node, std::string_view text) {
+  if (node.op == Op::kMatch || node.op == Op::kNoMatch) {
+    const bool found = std::regex_search(text.begin(), text.end(), node.regex);
+    return Known(found == (node.op == Op::kMatch));
+  }
+  return Known(Compare<std::string_view>(node.op, text, node.text));
+}
+
+Match CompareField(const Node& node, const Filter::Record& record) {
+  const bool stat = record.has_stat;
+  switch (node.field) {
+    case Field::kPid:
+      return Known(Compare<double>(node.op, record.pid, node.number));
+    case Field::kPpid:
+      return stat ? Known(Compare<double>(node.op, record.ppid, node.number))
+                  : Match::kUnknown;
+    case Field::kState:
+      return stat ? CompareText(node, std::string_view(&record.state, 1))
+                  : Match::kUnknown;
+    case Field::kComm:
+      return stat ? CompareText(node, record.comm) : Match::kUnknown;
+    case Field::kRam:
+      return stat ? Known(Compare<double>(node.op, record.ram_kb / 1024.0,
+                                          node.number))
+                  : Match::kUnknown;
+    case Field::kTime:
+      return stat ? Known(Compare<double>(node.op, record.uptime, node.number))
+                  : Match::kUnknown;
+    case Field::kUid:
+      if (record.uid < 0) {
+        return Match::kUnknown;
+      }
+      if (node.op == Op::kMatch || node.op == Op::kNoMatch) {
+        return CompareText(node, LinuxParser::UserName(record.uid));
+      }
+      return Known(Compare<double>(node.op, record.uid, node.number));
+    case Field::kCmd:
+      return record.command ? CompareText(node, *record.command)
+                            : Match::kUnknown;
+    case Field::kCpu:
+      return record.cpu >= 0 ? Known(Compare<double>(node.op, record.cpu * 100,
+                                                     node.number))
+                             : Match::kUnknown;
+  }
+  return Match::kUnknown;
+}
+
+// Three valued: false && unknown is false and true || unknown is true
+Match Evaluate(const Node& node, const Filter::Record& record) {
+  switch (node.kind) {
+    case Node::Kind::kAnd: {
+      Match result{Match::kYes};
+      for (const auto& child : node.children) {
+        const Match match = Evaluate(*child, record);
+        if (match == Match::kNo) {
+          return Match::kNo;
+        }
+        if (match == Match::kUnknown) {
+          result = Match::kUnknown;
+        }
+      }
+      return result;
+    }
+    case Node::Kind::kOr: {
+      Match result{Match::kNo};
+      for (const auto& child : node.children) {
+        const Match match = Evaluate(*child, record);
+        if (match == Match::kYes) {
+          return Match::kYes;
+        }
+        if (match == Match::kUnknown) {
+          result = Match::kUnknown;
+        }
+      }
+      return result;
+    }
+    case Node::Kind::kNot: {
+      const Match match = Evaluate(*node.children.front(), record);
+      return match == Match::kUnknown ? match : Known(match == Match::kNo);
+    }
+    case Node::Kind::kCompare:
+      return CompareField(node, record);
+  }
+  return Match::kUnknown;
+}
+
+// Set the bit of every cost some comparison below node needs
+unsigned CostsRead(const Node& node) {
+  unsigned reads = 0;
+  if (node.kind == Node::Kind::kCompare) {
+    reads |= 1u << static_cast<int>(node.cost);
+  }
+  for (const auto& child : node.children) {
+    reads |= CostsRead(*child);
+  }
+  return reads;
+}
+}  // namespace
+
+// Compile text into an evaluation plan; an empty text matches everything.
+// On a syntax error the filter is left as it was.
+bool Filter::Compile(const string& text, string& error) {
+  std::shared_ptr<const Node> root;
+  if (text.find_first_not_of(" \t") != string::npos) {
+    root = Parser(text).Parse(error);
+    if (!root) {
+      return false;
+    }
+  }
+  text_ = root ? text : string();
+  reads_ = root ? CostsRead(*root) : 0;
+  root_ = std::move(root);
+  return true;
+}
+
+bool Filter::Empty() const { return !root_; }
+
+const string& Filter::Text() const { return text_; }
+
+// Whether some comparison needs the fields that come at cost
+bool Filter::Reads(Cost cost) const {
+  return reads_ & (1u << static_cast<int>(cost));
+}
+
+Match Filter::Evaluate(const Record& record) const {
+  return root_ ? ::Evaluate(*root_, record) : Match::kYes;
+}
@@ -1,5 +1,6 @@
 #include "format.h"
 
+#include <cstdio>
 #include <string>
 
 using std::string;
@@ -18,4 +19,20 @@ string Format::ElapsedTime(long seconds) {
   string str_mins =
       (mins < 10) ? "0" + std::to_string(mins) : std::to_string(mins);
   return (str_hours + ":" + str_mins + ":" + str_secs);
-}
\ No newline at end of file
+}
+// Helper function
+// INPUT: a number of bytes
+// OUTPUT: at most 5 characters with a binary unit, such as 512B, 1.5K or 23M
+string Format::Bytes(double bytes) {
+  static const char kUnits[]{"BKMGTP"};
+  int unit{0};
+  while (bytes >= 1000 && kUnits[unit + 1] != '\0') {
+    bytes /= 1024;
+    ++unit;
+  }
+  char text[16];
+  std::snprintf(text, sizeof(text),
+                unit > 0 && bytes < 10 ? "%.1f%c" : "%.0f%c", bytes,
+                kUnits[unit]);
+  return text;
+}
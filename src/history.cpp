@@ -0,0 +1,196 @@
+#include "history.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using std::size_t;
+using std::uint16_t;
+using std::uint32_t;
+using std::vector;
+
+History::History(size_t capacity, long long window_ms)
+    : capacity_(std::clamp<size_t>(capacity, 1, kMaxCapacity)),
+      window_ms_(window_ms),
+      head_(capacity_ - 1),
+      times_(capacity_),
+      cpu_(capacity_),
+      memory_(capacity_),
+      slot_pid_(kSlots, -1),
+      slot_start_(kSlots),
+      slot_first_(kSlots),
+      slot_recorded_(kSlots),
+      slot_shown_(kSlots),
+      slot_cpu_(kSlots * capacity_),
+      slot_rss_(kSlots * capacity_) {
+  slot_of_.reserve(kSlots);
+}
+
+// Return the capacity that holds window_ms of samples taken every
+// interval_ms, up to kMaxCapacity
+size_t History::CapacityFor(long long window_ms, long long interval_ms) {
+  const long long samples{window_ms / std::max(1LL, interval_ms)};
+  return std::clamp<long long>(samples, 1, kMaxCapacity);
+}
+
+// Return the number of samples each series can hold
+size_t History::Capacity() const { return capacity_; }
+
+// Return the age beyond which samples are dropped, or 0
+long long History::Window() const { return window_ms_; }
+
+// Return the number of system samples held within the window
+size_t History::Size() const { return size_; }
+
+// Return the number of samples a whole window holds at the pace of those in
+// it, to lay a history out over its time span rather than over the rings.
+// Without a window, or before two samples, that is the capacity.
+size_t History::Length() const {
+  const long long span{times_[head_] -
+                       times_[(head_ + capacity_ + 1 - size_) % capacity_]};
+  if (window_ms_ <= 0 || size_ < 2 || span <= 0) {
+    return capacity_;
+  }
+  const long long gaps{static_cast<long long>(size_) - 1};
+  const long long length{window_ms_ * gaps / span};
+  return std::clamp<long long>(length, size_, capacity_);
+}
+
+// Convert a utilization of 0 to 1 to hundredths of a percent
+uint16_t History::Fixed(float utilization) {
+  const float clamped = std::min(1.0f, std::max(0.0f, utilization));
+  return static_cast<uint16_t>(clamped * kScale + 0.5f);
+}
+
+// Start a tick taken at time_ms with the system-wide sample, and drop the
+// samples that are now older than the window
+void History::Begin(long long time_ms, float cpu, float memory,
+                    const vector<float>& cores) {
+  ++ticks_;
+  head_ = (head_ + 1) % capacity_;
+  times_[head_] = time_ms;
+  size_ = std::min(size_ + 1, capacity_);
+  while (window_ms_ > 0 && size_ > 1 &&
+         times_[(head_ + capacity_ + 1 - size_) % capacity_] <
+             time_ms - window_ms_) {
+    --size_;
+  }
+  cpu_[head_] = Fixed(cpu);
+  memory_[head_] = Fixed(memory);
+  if (cores_.size() != cores.size() * capacity_) {
+    cores_.assign(cores.size() * capacity_, 0);
+  }
+  for (size_t core = 0; core < cores.size(); ++core) {
+    cores_[core * capacity_ + head_] = Fixed(cores[core]);
+  }
+}
+
+// Make sure the process has a slot and mark it as shown in this tick.
+// Returns the slot, or -1 when every slot belongs to a process shown in this
+// tick.
+int History::Track(int pid, long start_time) {
+  auto it = slot_of_.find(pid);
+  int slot;
+  if (it != slot_of_.end()) {
+    slot = it->second;
+    if (slot_start_[slot] == start_time) {
+      slot_shown_[slot] = ticks_;
+      return slot;
+    }
+    // The PID has been reused; the slot starts over
+  } else {
+    slot = -1;
+    for (size_t i = 0; i < kSlots; ++i) {
+      if (slot_pid_[i] < 0) {
+        slot = i;
+        break;
+      }
+      if (slot_shown_[i] != ticks_ &&
+          (slot < 0 || slot_shown_[i] < slot_shown_[slot])) {
+        slot = i;
+      }
+    }
+    if (slot < 0) {
+      return -1;
+    }
+    if (slot_pid_[slot] >= 0) {
+      slot_of_.erase(slot_pid_[slot]);
+    }
+    slot_of_[pid] = slot;
+  }
+  slot_pid_[slot] = pid;
+  slot_start_[slot] = start_time;
+  slot_first_[slot] = ticks_;
+  slot_recorded_[slot] = 0;
+  slot_shown_[slot] = ticks_;
+  return slot;
+}
+
+// Return the PID of a slot, or -1 if it is free
+int History::SlotPid(size_t slot) const { return slot_pid_[slot]; }
+
+// Return the start time of the process of a slot, to tell reused PIDs apart
+long History::SlotStartTime(size_t slot) const { return slot_start_[slot]; }
+
+// Add the sample of the current tick to a slot
+void History::Record(size_t slot, float cpu, long rss_kb) {
+  const long limit = std::numeric_limits<uint32_t>::max();
+  slot_cpu_[slot * capacity_ + head_] = Fixed(cpu);
+  slot_rss_[slot * capacity_ + head_] =
+      static_cast<uint32_t>(std::min(limit, std::max(0L, rss_kb)));
+  slot_recorded_[slot] = ticks_;
+}
+
+// Free the slots of processes that were not recorded in this tick
+void History::End() {
+  for (size_t slot = 0; slot < kSlots; ++slot) {
+    if (slot_pid_[slot] >= 0 && slot_recorded_[slot] != ticks_) {
+      slot_of_.erase(slot_pid_[slot]);
+      slot_pid_[slot] = -1;
+    }
+  }
+}
+
+// Copy the latest count samples of a ring, oldest first
+template <typename T>
+void History::Copy(const T* ring, size_t count, vector<T>& samples) const {
+  count = std::min(count, capacity_);
+  const size_t start = (head_ + capacity_ + 1 - count) % capacity_;
+  const size_t first = std::min(count, capacity_ - start);
+  samples.resize(count);
+  std::copy(ring + start, ring + start + first, samples.begin());
+  std::copy(ring, ring + (count - first), samples.begin() + first);
+}
+
+void History::Cpu(vector<uint16_t>& samples) const {
+  Copy(cpu_.data(), Size(), samples);
+}
+
+void History::Memory(vector<uint16_t>& samples) const {
+  Copy(memory_.data(), Size(), samples);
+}
+
+// Return the number of cores with a history
+size_t History::Cores() const { return cores_.size() / capacity_; }
+
+void History::Core(size_t core, vector<uint16_t>& samples) const {
+  Copy(cores_.data() + core * capacity_, Size(), samples);
+}
+
+// Copy the history of a tracked process, returning false if it has none
+bool History::Process(int pid, vector<uint16_t>& cpu,
+                      vector<uint32_t>& rss) const {
+  const auto it = slot_of_.find(pid);
+  if (it == slot_of_.end() || slot_recorded_[it->second] != ticks_) {
+    cpu.clear();
+    rss.clear();
+    return false;
+  }
+  const size_t slot = it->second;
+  const size_t count = std::min<size_t>(ticks_ - slot_first_[slot] + 1, size_);
+  Copy(slot_cpu_.data() + slot * capacity_, count, cpu);
+  Copy(slot_rss_.data() + slot * capacity_, count, rss);
+  return true;
+}
@@ -0,0 +1,101 @@
+#include "instrumentation.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+constexpr const char* kPhaseNames[] = {"scan", "parse", "sort",
+                                       "render_system", "render_processes"};
+constexpr const char* kCounterNames[] = {"opens", "reads", "bytes_read",
+                                         "proc_events"};
+}  // namespace
+
+const char* Instrumentation::PhaseName(Phase phase) {
+  return kPhaseNames[phase];
+}
+
+const char* Instrumentation::CounterName(Counter counter) {
+  return kCounterNames[counter];
+}
+
+#ifdef MONITOR_INSTRUMENTATION
+namespace {
+// Counters of one thread. Only the owning thread writes them, so the relaxed
+// atomics stay uncontended; they are atomic so Collect() can read them.
+struct alignas(64) Block {
+  std::atomic<std::int64_t> phase_ns[Instrumentation::kPhaseCount]{};
+  std::atomic<std::uint64_t> counters[Instrumentation::kCounterCount]{};
+};
+
+// All blocks ever created. Blocks are never freed, so a thread that exits
+// keeps its totals.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Block>> blocks;
+  Instrumentation::Tick collected;
+};
+
+Registry& Blocks() {
+  static Registry registry;
+  return registry;
+}
+
+Block& ThreadBlock() {
+  thread_local Block* block = [] {
+    auto& registry = Blocks();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.blocks.push_back(std::make_unique<Block>());
+    return registry.blocks.back().get();
+  }();
+  return *block;
+}
+
+std::int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+void Instrumentation::Add(Counter counter, std::uint64_t value) {
+  ThreadBlock().counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Instrumentation::AddTime(Phase phase, std::int64_t ns) {
+  ThreadBlock().phase_ns[phase].fetch_add(ns, std::memory_order_relaxed);
+}
+
+// Return what was counted since the previous call
+Instrumentation::Tick Instrumentation::Collect() {
+  auto& registry = Blocks();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  Tick total;
+  for (const auto& block : registry.blocks) {
+    for (int i = 0; i < kPhaseCount; ++i) {
+      total.phase_ns[i] += block->phase_ns[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < kCounterCount; ++i) {
+      total.counters[i] += block->counters[i].load(std::memory_order_relaxed);
+    }
+  }
+  Tick tick;
+  for (int i = 0; i < kPhaseCount; ++i) {
+    tick.phase_ns[i] = total.phase_ns[i] - registry.collected.phase_ns[i];
+  }
+  for (int i = 0; i < kCounterCount; ++i) {
+    tick.counters[i] = total.counters[i] - registry.collected.counters[i];
+  }
+  registry.collected = total;
+  return tick;
+}
+
+Instrumentation::ScopedTimer::ScopedTimer(Phase phase)
+    : phase_(phase), start_(Now()) {}
+
+Instrumentation::ScopedTimer::~ScopedTimer() {
+  AddTime(phase_, Now() - start_);
+}
+#endif
@@ -1,38 +1,298 @@
 #include "linux_parser.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "instrumentation.h"
+#include "proc_file.h"
+
 using std::ifstream;
 using std::istringstream;
 using std::stof;
 using std::stoi;
 using std::stol;
 using std::string;
+using std::string_view;
 using std::to_string;
 using std::vector;
 
-std::vector<std::string> StringToVector(string filename) {
-  std::vector<string> result;
-  std::string line, value;
-  std::ifstream f_stream(filename);
+namespace {
+// Size of the stack buffer used for /proc/[pid]/stat; a full line is well
+// under 1 KiB even with 64-bit counters and a 64 byte comm
+constexpr std::size_t kStatBufferSize{2048};
+// Size of the stack buffer used for /proc/[pid]/status
+constexpr std::size_t kStatusBufferSize{4096};
+
+// Read a whole (small) file into buffer, returning the number of bytes read
+// or -1 if the file could not be opened
+ssize_t ReadFileInto(const char *filename, char *buffer, std::size_t size) {
+  int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  MONITOR_COUNT(kOpens, 1);
+  if (fd < 0) {
+    return -1;
+  }
+  std::size_t total = 0;
+  while (total < size) {
+    ssize_t n = read(fd, buffer + total, size - total);
+    MONITOR_COUNT(kReads, 1);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    total += static_cast<std::size_t>(n);
+  }
+  close(fd);
+  MONITOR_COUNT(kBytesRead, total);
+  return static_cast<ssize_t>(total);
+}
 
-  if (f_stream) {
-    getline(f_stream, line);
-    std::istringstream lne_stream(line);
-    while (lne_stream >> value) {
-      result.push_back(value);
+// Skip spaces, then parse a signed decimal number
+const char *ScanLong(const char *p, const char *end, long &value) {
+  while (p < end && *p == ' ') ++p;
+  bool negative = false;
+  if (p < end && *p == '-') {
+    negative = true;
+    ++p;
+  }
+  long result = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    result = result * 10 + (*p++ - '0');
+  }
+  value = negative ? -result : result;
+  return p;
+}
+
+// Skip spaces and tabs
+const char *SkipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  return p;
+}
+
+// Skip spaces, then one space-separated field
+const char *SkipField(const char *p, const char *end) {
+  while (p < end && *p == ' ') ++p;
+  while (p < end && *p != ' ') ++p;
+  return p;
+}
+// Return the number following "key:" in a file of "key: value" lines
+long FindValue(string_view contents, string_view key) {
+  std::size_t start = 0;
+  while (start < contents.size()) {
+    auto end = contents.find('\n', start);
+    if (end == string_view::npos) {
+      end = contents.size();
+    }
+    const auto line = contents.substr(start, end - start);
+    if (line.size() > key.size() && line[key.size()] == ':' &&
+        line.substr(0, key.size()) == key) {
+      long value;
+      const char *p = SkipBlanks(line.data() + key.size() + 1,
+                                 line.data() + line.size());
+      ScanLong(p, line.data() + line.size(), value);
+      return value;
     }
+    start = end + 1;
   }
-  f_stream.close();
+  return 0;
+}
 
-  return result;
+// Append the names of the subdirectories of directory that are numbers
+void ListNumbers(const char *directory, vector<int> &numbers) {
+  DIR *stream = opendir(directory);
+  MONITOR_COUNT(kOpens, 1);
+  if (stream == nullptr) {
+    return;
+  }
+  struct dirent *file;
+  while ((file = readdir(stream)) != nullptr) {
+    // Is this a directory?
+    if (file->d_type == DT_DIR) {
+      // Is every character of the name a digit?
+      const string_view filename(file->d_name);
+      int number{0};
+      const auto result = std::from_chars(
+          filename.data(), filename.data() + filename.size(), number);
+      if (result.ec == std::errc() &&
+          result.ptr == filename.data() + filename.size()) {
+        numbers.push_back(number);
+      }
+    }
+  }
+  closedir(stream);
+}
+
+// Root of the proc filesystem, replaceable for tests and benchmarks
+string &ProcRoot() {
+  static string root{LinuxParser::kProcDirectory};
+  return root;
 }
 
+// Path of a file of /proc/[pid] or /proc/[pid]/task/[tid], built in a stack
+// buffer rather than by string concatenation, which would allocate for every
+// file of every process on every refresh. A path too long for the buffer is
+// left empty, so opening it fails.
+class ProcPath {
+ public:
+  ProcPath(int pid, string_view filename) {
+    Append(ProcRoot());
+    Append(pid);
+    Append(filename);
+  }
+  ProcPath(int pid, int tid, string_view filename) {
+    Append(ProcRoot());
+    Append(pid);
+    Append(LinuxParser::kTaskDirectory);
+    Append(tid);
+    Append(filename);
+  }
+
+  const char *c_str() const { return overflow_ ? "" : buffer_; }
+
+ private:
+  void Append(string_view part) {
+    if (size_ + part.size() >= sizeof(buffer_)) {
+      overflow_ = true;
+      return;
+    }
+    std::memcpy(buffer_ + size_, part.data(), part.size());
+    size_ += part.size();
+    buffer_[size_] = '\0';
+  }
+  void Append(int number) {
+    char digits[16];
+    const auto result =
+        std::to_chars(digits, digits + sizeof(digits), number);
+    Append(string_view(digits, result.ptr - digits));
+  }
+
+  char buffer_[PATH_MAX];
+  std::size_t size_{0};
+  bool overflow_{false};
+};
+
+// Read the first line of the command line of a process into command, with
+// its arguments separated by spaces instead of NUL characters. Templated on
+// the string so that workers can read into their arena.
+template <typename String>
+void ReadCommand(int pid, String &command) {
+  command.clear();
+  const int fd = open(ProcPath(pid, LinuxParser::kCmdlineFilename).c_str(),
+                      O_RDONLY | O_CLOEXEC);
+  MONITOR_COUNT(kOpens, 1);
+  if (fd < 0) {
+    return;
+  }
+  char buffer[4096];
+  while (true) {
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    MONITOR_COUNT(kReads, 1);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    command.append(buffer, n);
+  }
+  close(fd);
+  MONITOR_COUNT(kBytesRead, command.size());
+  command.resize(std::min(command.find('\n'), command.size()));
+  // Arguments are separated (and terminated) by NUL characters
+  while (!command.empty() && command.back() == '\0') {
+    command.pop_back();
+  }
+  std::replace(command.begin(), command.end(), '\0', ' ');
+}
+
+// System-wide files kept open until the proc root changes
+struct SystemFiles {
+  ProcFile stat{ProcRoot() + LinuxParser::kStatFilename};
+  ProcFile meminfo{ProcRoot() + LinuxParser::kMeminfoFilename};
+  ProcFile uptime{ProcRoot() + LinuxParser::kUptimeFilename};
+  ProcFile loadavg{ProcRoot() + LinuxParser::kLoadavgFilename};
+  ProcFile vmstat{ProcRoot() + LinuxParser::kVmstatFilename};
+  ProcFile pressure[LinuxParser::kPressureResources]{
+      ProcFile(ProcRoot() + LinuxParser::kPressureDirectory + "cpu"),
+      ProcFile(ProcRoot() + LinuxParser::kPressureDirectory + "memory"),
+      ProcFile(ProcRoot() + LinuxParser::kPressureDirectory + "io")};
+  // Kernels built without PSI have no pressure files; they are not looked
+  // for again once missing
+  bool pressure_missing[LinuxParser::kPressureResources]{};
+};
+
+std::unique_ptr<SystemFiles> &FilesSlot() {
+  static std::unique_ptr<SystemFiles> files;
+  return files;
+}
+
+SystemFiles &Files() {
+  auto &files = FilesSlot();
+  if (!files) {
+    files = std::make_unique<SystemFiles>();
+  }
+  return *files;
+}
+
+// How often /etc/passwd is checked for modification
+constexpr std::chrono::seconds kPasswordCheckInterval{1};
+
+// UID to user name map, keyed on the identity of /etc/passwd
+struct UserCache {
+  std::mutex mutex;
+  std::unordered_map<int, string> names;
+  dev_t device{0};
+  ino_t inode{0};
+  timespec mtime{};
+  std::chrono::steady_clock::time_point checked{};
+};
+
+UserCache &Users() {
+  static UserCache cache;
+  return cache;
+}
+
+// Replace names with the name:password:uid:... entries of /etc/passwd
+void LoadPasswordFile(std::unordered_map<int, string> &names) {
+  names.clear();
+  std::ifstream f_stream(LinuxParser::kPasswordPath);
+  string line;
+  while (getline(f_stream, line)) {
+    const auto name_end = line.find(':');
+    const auto password_end = line.find(':', name_end + 1);
+    if (name_end == string::npos || password_end == string::npos) {
+      continue;
+    }
+    const int uid = atoi(line.c_str() + password_end + 1);
+    names.emplace(uid, line.substr(0, name_end));
+  }
+}
+}  // namespace
+
 //  An example of how to read data from the filesystem
 string LinuxParser::OperatingSystem() {
   string line;
@@ -67,7 +327,7 @@ string LinuxParser::OperatingSystem() {
 string LinuxParser::Kernel() {
   string os, version, kernel;
   string line;
-  std::ifstream f_stream(kProcDirectory + kVersionFilename);
+  std::ifstream f_stream(ProcDirectory() + kVersionFilename);
   if (f_stream.is_open()) {
     std::getline(f_stream, line);
     std::istringstream lne_stream(line);
@@ -77,218 +337,516 @@ string LinuxParser::Kernel() {
   return kernel;
 }
 
+// Return where the cgroup v2 hierarchy is mounted, found once in the mount
+// table; empty if there is none or if /proc is not the real one, whose
+// cgroup paths would not match
+const string &LinuxParser::CgroupMount() {
+  static const string mount = [] {
+    std::ifstream f_stream(kMountsPath);
+    string device, directory, type;
+    string line;
+    while (std::getline(f_stream, line)) {
+      std::istringstream line_stream(line);
+      if (line_stream >> device >> directory >> type && type == "cgroup2") {
+        return directory;
+      }
+    }
+    return string();
+  }();
+  static const string none;
+  return ProcDirectory() == kProcDirectory ? mount : none;
+}
+
 // BONUS: Update this to use std::filesystem
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  DIR *directory = opendir(kProcDirectory.c_str());
-  struct dirent *file;
-  while ((file = readdir(directory)) != nullptr) {
-    // Is this a directory?
-    if (file->d_type == DT_DIR) {
-      // Is every character of the name a digit?
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
-      }
-    }
-  }
-  closedir(directory);
+  Pids(pids);
   return pids;
 }
 
+// Replace the contents of pids with the PIDs, reusing its storage
+void LinuxParser::Pids(vector<int> &pids) {
+  MONITOR_TIME_PHASE(kScan);
+  pids.clear();
+  ListNumbers(ProcDirectory().c_str(), pids);
+}
+
+// Replace the contents of tids with the IDs of the threads of a process
+void LinuxParser::Tids(int pid, vector<int> &tids) {
+  tids.clear();
+  ListNumbers(ProcPath(pid, kTaskDirectory).c_str(), tids);
+}
+
+// Return the root of the proc filesystem, ending in '/'
+const string &LinuxParser::ProcDirectory() { return ProcRoot(); }
+
+// Read from another proc root, such as a synthetic tree. Must be called
+// before collection starts; files kept open are reopened under the new root.
+void LinuxParser::SetProcDirectory(const string &directory) {
+  ProcRoot() = directory;
+  if (ProcRoot().empty() || ProcRoot().back() != '/') {
+    ProcRoot() += '/';
+  }
+  FilesSlot().reset();
+}
+
 // Read and return the system memory utilization
 float LinuxParser::MemoryUtilization() {
-  auto total_memory =
-      static_cast<float>(LinuxParser::ReadProcessMemory("MemTotal"));
-  auto avail_memory =
-      static_cast<float>(LinuxParser::ReadProcessMemory("MemFree"));
-  auto result = (total_memory - avail_memory) / total_memory;
-  return result;
+  MemInfo meminfo;
+  return ReadMemInfo(meminfo) ? meminfo.Utilization() : 0;
 }
 
-// Read and return the system memory utilization
+// Share of memory in use: what the kernel could not hand out without
+// swapping. Page cache and reclaimable slab count as available.
+float LinuxParser::MemInfo::Utilization() const {
+  if (total <= 0) {
+    return 0;
+  }
+  return static_cast<float>(total - available) / total;
+}
+
+bool LinuxParser::ReadMemInfo(MemInfo &meminfo) {
+  string_view contents;
+  if (!Files().meminfo.Read(contents)) {
+    return false;
+  }
+  return ParseMemInfo(contents.data(), contents.size(), meminfo);
+}
+
+// Parse /proc/meminfo in a single pass, stopping once every field is found.
+// Kernels older than 3.14 have no MemAvailable; it is estimated from the
+// free memory and the page cache there.
+bool LinuxParser::ParseMemInfo(const char *buffer, std::size_t size,
+                               MemInfo &meminfo) {
+  static constexpr struct {
+    string_view key;
+    long MemInfo::*field;
+  } kFields[]{{"MemTotal", &MemInfo::total},
+              {"MemFree", &MemInfo::free},
+              {"MemAvailable", &MemInfo::available},
+              {"Buffers", &MemInfo::buffers},
+              {"Cached", &MemInfo::cached},
+              {"Slab", &MemInfo::slab},
+              {"SwapTotal", &MemInfo::swap_total},
+              {"SwapFree", &MemInfo::swap_free},
+              {"Dirty", &MemInfo::dirty}};
+  meminfo = MemInfo{};
+  meminfo.available = -1;
+  std::size_t found{0};
+  const char *p = buffer;
+  const char *end = buffer + size;
+  while (p < end && found < std::size(kFields)) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    const char *colon = static_cast<const char *>(std::memchr(p, ':', eol - p));
+    if (colon != nullptr) {
+      const string_view key(p, colon - p);
+      for (const auto &field : kFields) {
+        if (key == field.key) {
+          ScanLong(SkipBlanks(colon + 1, eol), eol, meminfo.*field.field);
+          ++found;
+          break;
+        }
+      }
+    }
+    p = eol + 1;
+  }
+  if (meminfo.available < 0) {
+    meminfo.available = meminfo.free + meminfo.buffers + meminfo.cached;
+  }
+  return meminfo.total > 0;
+}
+
+// Read the paging counters of /proc/vmstat
+bool LinuxParser::ReadVmStat(VmStat &vmstat) {
+  static constexpr struct {
+    string_view key;
+    long VmStat::*field;
+  } kFields[]{{"pgfault", &VmStat::pgfault},
+              {"pgmajfault", &VmStat::pgmajfault},
+              {"pswpin", &VmStat::pswpin},
+              {"pswpout", &VmStat::pswpout}};
+  string_view contents;
+  if (!Files().vmstat.Read(contents)) {
+    return false;
+  }
+  vmstat = VmStat{};
+  std::size_t found{0};
+  const char *p = contents.data();
+  const char *end = p + contents.size();
+  while (p < end && found < std::size(kFields)) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    const char *space = static_cast<const char *>(std::memchr(p, ' ', eol - p));
+    if (space != nullptr) {
+      const string_view key(p, space - p);
+      for (const auto &field : kFields) {
+        if (key == field.key) {
+          ScanLong(space, eol, vmstat.*field.field);
+          ++found;
+          break;
+        }
+      }
+    }
+    p = eol + 1;
+  }
+  return found > 0;
+}
+
+// Read the "some" and "full" averages of one /proc/pressure file. The CPU
+// file of kernels before 5.13 has no "full" line.
+bool LinuxParser::ReadPressure(PressureResource resource, Pressure &pressure) {
+  auto &files = Files();
+  pressure = Pressure{};
+  string_view contents;
+  if (files.pressure_missing[resource]) {
+    return false;
+  }
+  if (!files.pressure[resource].Read(contents)) {
+    files.pressure_missing[resource] = true;
+    return false;
+  }
+  char text[256]{};
+  contents.copy(text, sizeof(text) - 1);
+  const char *full = std::strstr(text, "full");
+  if (std::sscanf(text, "some avg10=%f avg60=%f avg300=%f", &pressure.some[0],
+                  &pressure.some[1], &pressure.some[2]) != 3) {
+    return false;
+  }
+  if (full != nullptr) {
+    std::sscanf(full, "full avg10=%f avg60=%f avg300=%f", &pressure.full[0],
+                &pressure.full[1], &pressure.full[2]);
+  }
+  return true;
+}
+
+// Read and return the system uptime
 long LinuxParser::UpTime() {
-  string line;
-  string str_value;
+  string_view contents;
   long value = 0;
-  std::ifstream f_stream(kProcDirectory + kUptimeFilename);
-
-  if (f_stream.is_open()) {
-    getline(f_stream, line);
-    std::istringstream lne_stream(line);
-    lne_stream >> str_value;
-    value = stol(str_value);
+  if (Files().uptime.Read(contents)) {
+    ScanLong(contents.data(), contents.data() + contents.size(), value);
   }
-  f_stream.close();
   return value;
 }
 
+// Read the 1, 5 and 15 minute load averages
+bool LinuxParser::LoadAverage(float (&load)[3]) {
+  string_view contents;
+  if (!Files().loadavg.Read(contents)) {
+    return false;
+  }
+  char text[128]{};
+  contents.copy(text, sizeof(text) - 1);
+  return std::sscanf(text, "%f %f %f", &load[0], &load[1], &load[2]) == 3;
+}
+
 // Read and return the number of jiffies for the system
 long LinuxParser::Jiffies() {
-  auto total_jiffies = ActiveJiffies() - IdleJiffies();
-  return total_jiffies;
+  StatSnapshot snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.cpu.Total();
 }
 
 // Read and return the number of active jiffies for a PID
 long LinuxParser::ActiveJiffies(int pid) {
-  std::string filename = kProcDirectory + to_string(pid) + kStatFilename;
-  std::vector<string> vstr = StringToVector(filename);
-  long result = 0;
-  if (vstr.size() >= 21) {
-    result =
-        (stol(vstr[13]) + stol(vstr[14]) + stol(vstr[15]) + stol(vstr[16]));
+  ProcStat stat;
+  if (!ReadProcStat(pid, stat)) {
+    return 0;
   }
-  return result;
+  return stat.utime + stat.stime + stat.cutime + stat.cstime;
 }
+
 // Read and return the number of active jiffies for the system
 long LinuxParser::ActiveJiffies() {
-  const auto cpu_stats = LinuxParser::CpuUtilization();
-  const auto user = stol(cpu_stats[LinuxParser::kUser_]);
-  const auto nice = stol(cpu_stats[LinuxParser::kNice_]);
-  const auto system = stol(cpu_stats[LinuxParser::kSystem_]);
-  const auto idle = stol(cpu_stats[LinuxParser::kIdle_]);
-  const auto iowait = stol(cpu_stats[LinuxParser::kIOwait_]);
-  const auto irq = stol(cpu_stats[LinuxParser::kIRQ_]);
-  const auto softirq = stol(cpu_stats[LinuxParser::kSoftIRQ_]);
-  const auto steal = stol(cpu_stats[LinuxParser::kSteal_]);
-  long result = user + nice + system + idle + iowait + irq + softirq + steal;
-  return result;
+  StatSnapshot snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.cpu.Active();
 }
 
 // Read and return the number of idle jiffies for the system
 long LinuxParser::IdleJiffies() {
-  const auto cpu_stats = LinuxParser::CpuUtilization();
-  const auto idle = stol(cpu_stats[LinuxParser::kIdle_]);
-  const auto iowait = stol(cpu_stats[LinuxParser::kIOwait_]);
-  return idle + iowait;
+  StatSnapshot snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.cpu.Idle();
 }
 
 // Read and return CPU utilization
 vector<string> LinuxParser::CpuUtilization() {
-  std::vector<string> result;
-  std::string line, val;
-
-  std::ifstream stream(kProcDirectory + kStatFilename);
-  if (stream) {
-    getline(stream, line);
-
-    std::istringstream lne_stream(line);
-    lne_stream >> val;
-    for (int i = CPUStates::kUser_; i < CPUStates::kGuestNice_; i++) {
-      lne_stream >> val;
-      result.push_back(val);
-    }
+  StatSnapshot snapshot;
+  ReadStatSnapshot(snapshot);
+  vector<string> result;
+  for (int i = CPUStates::kUser_; i < CPUStates::kGuestNice_; i++) {
+    result.push_back(to_string(snapshot.cpu.jiffies[i]));
   }
-  stream.close();
   return result;
 }
 
 // Read and return the total number of processes
 int LinuxParser::TotalProcesses() {
-  std::string line;
-  std::string key;
-  string val;
-  std::ifstream f_stream(kProcDirectory + kStatFilename);
-  if (f_stream) {
-    bool exitouterloop = false;
-    while (getline(f_stream, line)) {
-      std::istringstream lne_stream(line);
-      while (lne_stream >> key >> val) {
-        if (key == "processes") {
-          exitouterloop = true;
-          break;
-        }
-      }
-      if (exitouterloop) {
-        break;
-      }
-    }
-  }
-  f_stream.close();
-  return stoi(val);
+  StatSnapshot snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.processes;
 }
 
 // Read and return the number of running processes
 int LinuxParser::RunningProcesses() {
-  string line;
-  string key;
-  int val;
-  ifstream f_stream(kProcDirectory + kStatFilename);
-  if (f_stream) {
-    bool exitouterloop = false;
-    while (getline(f_stream, line)) {
-      std::istringstream lne_stream(line);
-      while (lne_stream >> key >> val) {
-        if (key == "procs_running") {
-          exitouterloop = true;
-          break;
+  StatSnapshot snapshot;
+  ReadStatSnapshot(snapshot);
+  return snapshot.procs_running;
+}
+
+// Sum of the jiffies spent in every state except guest time, which the
+// kernel already accounts for in user and nice
+long LinuxParser::CpuTimes::Total() const {
+  long result = 0;
+  for (int i = CPUStates::kUser_; i <= CPUStates::kSteal_; i++) {
+    result += jiffies[i];
+  }
+  return result;
+}
+
+long LinuxParser::CpuTimes::Idle() const {
+  return jiffies[kIdle_] + jiffies[kIOwait_];
+}
+
+long LinuxParser::CpuTimes::Active() const { return Total() - Idle(); }
+
+// Read /proc/stat once
+bool LinuxParser::ReadStatSnapshot(StatSnapshot &snapshot) {
+  string_view contents;
+  if (!Files().stat.Read(contents)) {
+    return false;
+  }
+  return ParseStatSnapshot(contents.data(), contents.size(), snapshot);
+}
+
+// Parse the contents of /proc/stat. Per-core lines are stored at their CPU
+// number, so offline CPUs leave zeroed entries.
+bool LinuxParser::ParseStatSnapshot(const char *buffer, std::size_t size,
+                                    StatSnapshot &snapshot) {
+  // The snapshot is reused between reads: clear what a CPU gone offline
+  // would otherwise keep from the previous one
+  std::fill(snapshot.cores.begin(), snapshot.cores.end(), CpuTimes{});
+  std::size_t cores = 0;
+  const char *p = buffer;
+  const char *end = buffer + size;
+  while (p < end) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    const char *key_end = p;
+    while (key_end < eol && *key_end != ' ') ++key_end;
+    const string_view key(p, key_end - p);
+    long value;
+    if (key.substr(0, 3) == "cpu") {
+      CpuTimes *times = &snapshot.cpu;
+      if (key.size() > 3) {
+        ScanLong(p + 3, key_end, value);
+        const auto core = static_cast<std::size_t>(value);
+        cores = std::max(cores, core + 1);
+        if (snapshot.cores.size() < cores) {
+          snapshot.cores.resize(cores);
         }
+        times = &snapshot.cores[core];
       }
-      if (exitouterloop) {
-        break;
+      const char *field = key_end;
+      for (int i = CPUStates::kUser_; i <= CPUStates::kGuestNice_; i++) {
+        field = ScanLong(field, eol, times->jiffies[i]);
       }
+    } else if (key == "ctxt") {
+      ScanLong(key_end, eol, snapshot.ctxt);
+    } else if (key == "intr") {
+      ScanLong(key_end, eol, snapshot.intr);
+    } else if (key == "processes") {
+      ScanLong(key_end, eol, snapshot.processes);
+    } else if (key == "procs_running") {
+      ScanLong(key_end, eol, value);
+      snapshot.procs_running = static_cast<int>(value);
+    } else if (key == "procs_blocked") {
+      ScanLong(key_end, eol, value);
+      snapshot.procs_blocked = static_cast<int>(value);
     }
-    f_stream.close();
+    p = eol + 1;
   }
-  return val;
+  snapshot.cores.resize(cores);
+  return cores > 0;
 }
 
 // Read and return the command associated with a process
 string LinuxParser::Command(int pid) {
-  std::string line;
-  std::string str_pid = to_string(pid);
-  std::ifstream f_stream(kProcDirectory + str_pid + kCmdlineFilename);
+  string command;
+  ReadCommand(pid, command);
+  return command;
+}
 
-  if (f_stream) {
-    getline(f_stream, line);
-  }
-  f_stream.close();
-  return line;
+// Read the command associated with a process into command, which may
+// allocate from a per-refresh arena
+void LinuxParser::Command(int pid, std::pmr::string &command) {
+  ReadCommand(pid, command);
 }
 
 // Read and return the memory used by a process
 string LinuxParser::Ram(int pid) {
   const auto kb2mb = 1024;
-  const auto mbMem = (ReadProcessID(pid, "VmRSS") / kb2mb);
-  return to_string(mbMem);
+  ProcStatus status;
+  ReadProcStatus(pid, status);
+  return to_string(status.vm_rss / kb2mb);
 }
 
-// TODO: Read and return the user ID associated with a process
+// Read and return the user ID associated with a process
 string LinuxParser::Uid(int pid) {
-  const auto uid = ReadProcessID(pid, "Uid");
-  return to_string(uid);
+  ProcStatus status;
+  ReadProcStatus(pid, status);
+  return to_string(status.uid);
 }
 
-// TODO: Read and return the user associated with a process
-// REMOVE: [[maybe_unused]] once you define the function
+// Read and return the user associated with a process
 string LinuxParser::User(int pid) {
-  std::string key = LinuxParser::Uid(pid);
-  std::string line, uid_str, user;
+  ProcStatus status;
+  if (!ReadProcStatus(pid, status)) {
+    return string();
+  }
+  return UserName(status.uid);
+}
 
-  std::ifstream f_stream(kPasswordPath);
+// Read the fields of /proc/[pid]/status used by the monitor in one read
+bool LinuxParser::ReadProcStatus(int pid, ProcStatus &status) {
+  status = ProcStatus{};
+  char buffer[kStatusBufferSize];
+  const auto size =
+      ReadFileInto(ProcPath(pid, kStatusFilename).c_str(), buffer,
+                   sizeof(buffer));
+  if (size <= 0) {
+    return false;
+  }
+  const char *p = buffer;
+  const char *end = buffer + size;
+  while (p < end) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    const char *colon = static_cast<const char *>(std::memchr(p, ':', eol - p));
+    if (colon != nullptr) {
+      const string_view key(p, colon - p);
+      long value;
+      if (key == "Uid") {
+        ScanLong(SkipBlanks(colon + 1, eol), eol, value);
+        status.uid = static_cast<int>(value);
+      } else if (key == "VmRSS") {
+        ScanLong(SkipBlanks(colon + 1, eol), eol, status.vm_rss);
+      }
+    }
+    p = eol + 1;
+  }
+  return status.uid >= 0;
+}
 
-  if (f_stream) {
-    bool exitouterloop = false;
-    while (getline(f_stream, line)) {
-      std::replace(line.begin(), line.end(), ' ', '_');
-      std::replace(line.begin(), line.end(), ':', ' ');
-      std::replace(line.begin(), line.end(), 'x', ' ');
-      std::istringstream lne_stream(line);
+// Read the cgroup v2 path of a process, the "0::" line of
+// /proc/[pid]/cgroup. path is left empty on hosts with only cgroup v1.
+bool LinuxParser::ReadProcCgroup(int pid, std::pmr::string &path) {
+  path.clear();
+  char buffer[kStatusBufferSize];
+  const auto size =
+      ReadFileInto(ProcPath(pid, kCgroupFilename).c_str(), buffer,
+                   sizeof(buffer));
+  if (size <= 0) {
+    return false;
+  }
+  const string_view contents(buffer, size);
+  std::size_t start = 0;
+  while (start < contents.size()) {
+    auto end = contents.find('\n', start);
+    if (end == string_view::npos) {
+      end = contents.size();
+    }
+    const auto line = contents.substr(start, end - start);
+    if (line.substr(0, 3) == "0::") {
+      path.assign(line.substr(3));
+      break;
+    }
+    start = end + 1;
+  }
+  return true;
+}
 
-      while (lne_stream >> user >> uid_str) {
-        if (uid_str == key) {
-          exitouterloop = true;
-          break;
-        };
-      }
-      if (exitouterloop) {
-        break;
-      }
+// Read the storage I/O counters of /proc/[pid]/io, which only the owner of
+// the process (or root) may read
+bool LinuxParser::ReadProcIo(int pid, ProcIo &io) {
+  char buffer[kStatusBufferSize];
+  const auto size =
+      ReadFileInto(ProcPath(pid, kIoFilename).c_str(), buffer, sizeof(buffer));
+  if (size <= 0) {
+    return false;
+  }
+  const string_view contents(buffer, size);
+  io.read_bytes = FindValue(contents, "read_bytes");
+  io.write_bytes = FindValue(contents, "write_bytes");
+  return true;
+}
+
+// Read the proportional set size and the swap of a process from
+// /proc/[pid]/smaps_rollup. The kernel walks every mapping to produce it, so
+// it is only read for the processes on screen.
+bool LinuxParser::ReadProcMemory(int pid, ProcMemory &memory) {
+  char buffer[kStatusBufferSize];
+  const auto size =
+      ReadFileInto(ProcPath(pid, kSmapsRollupFilename).c_str(),
+                   buffer, sizeof(buffer));
+  if (size <= 0) {
+    return false;
+  }
+  const string_view contents(buffer, size);
+  memory.pss = FindValue(contents, "Pss");
+  memory.swap = FindValue(contents, "Swap");
+  return true;
+}
+
+// Return the name of a user, served from a cache of /etc/passwd that is
+// reloaded only when the file changes. UIDs missing from the file (LDAP,
+// NIS, ...) are resolved once through getpwuid_r.
+string LinuxParser::UserName(int uid) {
+  auto &cache = Users();
+  std::unique_lock<std::mutex> lock(cache.mutex);
+  const auto now = std::chrono::steady_clock::now();
+  if (now - cache.checked >= kPasswordCheckInterval) {
+    cache.checked = now;
+    struct stat info;
+    if (stat(kPasswordPath.c_str(), &info) == 0 &&
+        (info.st_ino != cache.inode || info.st_dev != cache.device ||
+         info.st_mtim.tv_sec != cache.mtime.tv_sec ||
+         info.st_mtim.tv_nsec != cache.mtime.tv_nsec)) {
+      cache.inode = info.st_ino;
+      cache.device = info.st_dev;
+      cache.mtime = info.st_mtim;
+      LoadPasswordFile(cache.names);
     }
   }
-  f_stream.close();
-  return user;
+
+  const auto it = cache.names.find(uid);
+  if (it != cache.names.end()) {
+    return it->second;
+  }
+  // Users missing from /etc/passwd come from NSS, which may ask the network;
+  // other threads keep reading the cache meanwhile. Should two look up the
+  // same UID, the first name inserted is kept.
+  lock.unlock();
+  struct passwd entry;
+  struct passwd *result = nullptr;
+  char buffer[1024];
+  string name = to_string(uid);
+  if (getpwuid_r(uid, &entry, buffer, sizeof(buffer), &result) == 0 &&
+      result != nullptr) {
+    name = result->pw_name;
+  }
+  lock.lock();
+  return cache.names.emplace(uid, std::move(name)).first->second;
 }
 
 // Determine the ticks per second as a vector of string
@@ -296,56 +854,114 @@ int LinuxParser::ClockTicksPerSecond() { return sysconf(_SC_CLK_TCK); }
 
 //  Read and return the uptime of a process
 long LinuxParser::UpTime(int pid) {
-  auto string_pid = to_string(pid);
-  std::vector<string> result =
-      StringToVector(kProcDirectory + string_pid + kStatFilename);
-  if (result.size() >= 21) {
-    const auto start = stol(result[21]);
-    return UpTime() - (start / ClockTicksPerSecond());
+  ProcStat stat;
+  if (!ReadProcStat(pid, stat)) {
+    return 0;
   }
+  return UpTime() - (stat.starttime / ClockTicksPerSecond());
+}
 
-  return 0;
+// Read /proc/[pid]/stat with a single read into a stack buffer
+bool LinuxParser::ReadProcStat(int pid, ProcStat &stat) {
+  char buffer[kStatBufferSize];
+  const auto size =
+      ReadFileInto(ProcPath(pid, kStatFilename).c_str(), buffer,
+                   sizeof(buffer));
+  if (size <= 0) {
+    return false;
+  }
+  return ParseProcStat(buffer, static_cast<std::size_t>(size), stat);
 }
 
-// Helper function to determine process information (parsing)
-long ReadProcessInfo(const std::string filename, const std::string search_key) {
-  std::string line, key, str_value;
-  std::ifstream f_stream(filename);
-  long result = 0;
+// Read /proc/[pid]/task/[tid]/stat, whose comm is the thread's name
+bool LinuxParser::ReadTaskStat(int pid, int tid, ProcStat &stat) {
+  char buffer[kStatBufferSize];
+  const auto size = ReadFileInto(ProcPath(pid, tid, kStatFilename).c_str(),
+                                 buffer, sizeof(buffer));
+  if (size <= 0) {
+    return false;
+  }
+  return ParseProcStat(buffer, static_cast<std::size_t>(size), stat);
+}
 
-  if (f_stream) {
-    bool exitouterloop = false;
-    while (getline(f_stream, line)) {
-      std::replace(line.begin(), line.end(), ':', ' ');
-      std::istringstream lne_stream(line);
+// Parse the contents of a stat file. comm is delimited by the first '(' and
+// the last ')' because it may itself contain spaces and parentheses.
+bool LinuxParser::ParseProcStat(const char *buffer, std::size_t size,
+                                ProcStat &stat) {
+  const char *end = buffer + size;
+  const char *open_paren =
+      static_cast<const char *>(std::memchr(buffer, '(', size));
+  const char *close_paren =
+      static_cast<const char *>(memrchr(buffer, ')', size));
+  if (open_paren == nullptr || close_paren == nullptr ||
+      close_paren < open_paren) {
+    return false;
+  }
 
-      while (lne_stream >> key >> str_value) {
-        if (key == search_key) {
-          exitouterloop = true;
-          break;
-        }
-      }
-      if (exitouterloop) {
-        result = stol(str_value);
-        break;
-      } else
-        result = 0;
-    }
+  long value;
+  ScanLong(buffer, open_paren, value);
+  stat.pid = static_cast<int>(value);
+  const std::size_t comm_length = std::min<std::size_t>(
+      close_paren - open_paren - 1, sizeof(stat.comm) - 1);
+  std::memcpy(stat.comm, open_paren + 1, comm_length);
+  stat.comm[comm_length] = '\0';
+
+  // Field numbers below follow proc(5); comm is field 2
+  const char *p = close_paren + 1;
+  while (p < end && *p == ' ') ++p;
+  if (p >= end) {
+    return false;
   }
-  f_stream.close();
-  return result;
+  stat.state = *p++;            // 3
+  p = ScanLong(p, end, value);  // 4
+  stat.ppid = static_cast<int>(value);
+  for (int field = 5; field <= 11; ++field) {
+    p = SkipField(p, end);
+  }
+  p = ScanLong(p, end, stat.majflt);  // 12
+  p = SkipField(p, end);              // 13
+  p = ScanLong(p, end, stat.utime);   // 14
+  p = ScanLong(p, end, stat.stime);   // 15
+  p = ScanLong(p, end, stat.cutime);  // 16
+  p = ScanLong(p, end, stat.cstime);  // 17
+  for (int field = 18; field <= 19; ++field) {
+    p = SkipField(p, end);
+  }
+  p = ScanLong(p, end, stat.num_threads);  // 20
+  p = SkipField(p, end);                   // 21
+  p = ScanLong(p, end, stat.starttime);    // 22
+  p = SkipField(p, end);                   // 23
+  ScanLong(p, end, stat.rss);              // 24
+  return true;
 }
 
 // Helper function to read process memory
 long LinuxParser::ReadProcessMemory(const std::string search_key) {
-  std::string filename = kProcDirectory + kMeminfoFilename;
-  auto result = ReadProcessInfo(filename, search_key);
-  return result;
+  string_view contents;
+  if (!Files().meminfo.Read(contents)) {
+    return 0;
+  }
+  return FindValue(contents, search_key);
 }
 
 // Helper function to read process ID
 long LinuxParser::ReadProcessID(const int &pid, const std::string search_key) {
-  std::string filename = kProcDirectory + std::to_string(pid) + kStatusFilename;
-  auto result = ReadProcessInfo(filename, search_key);
-  return result;
-}
\ No newline at end of file
+  char buffer[kStatusBufferSize];
+  const auto size = ReadFileInto(ProcPath(pid, kStatusFilename).c_str(),
+                                 buffer, sizeof(buffer));
+  if (size <= 0) {
+    return 0;
+  }
+  return FindValue(string_view(buffer, size), search_key);
+}
+
+// Bytes written by this process so far, from the wchar field of its own
+// /proc/self/io. Always the real /proc, whatever the proc root is.
+long LinuxParser::WrittenBytes() {
+  thread_local ProcFile io{kSelfIoPath};
+  string_view contents;
+  if (!io.Read(contents)) {
+    return 0;
+  }
+  return FindValue(contents, "wchar");
+}
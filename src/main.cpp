@@ -1,7 +1,91 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "collector.h"
+#include "command_line.h"
+#include "filter.h"
+#include "linux_parser.h"
+#include "metrics_server.h"
 #include "ncurses_display.h"
+#include "ndjson_output.h"
+#include "player.h"
+#include "recording.h"
+#include "refresh_scheduler.h"
 #include "system.h"
 
-int main() {
-  System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+int main(int argc, char* argv[]) {
+  CommandLine::Options options;
+  std::string error;
+  if (!CommandLine::Parse(argc, argv, options, error)) {
+    std::cerr << "monitor: " << error << "\n" << CommandLine::Usage();
+    return 1;
+  }
+  Filter filter;
+  if (!filter.Compile(options.filter, error)) {
+    std::cerr << "monitor: invalid filter: " << error << "\n";
+    return 1;
+  }
+  if (!options.proc_root.empty()) {
+    LinuxParser::SetProcDirectory(options.proc_root);
+  }
+  if (!options.watch.empty()) {
+    NdjsonOutput::Watch(options.watch, options.interval_ms, options.count);
+    return 0;
+  }
+  if (!options.replay.empty()) {
+    Player player;
+    if (!player.Open(options.replay, error)) {
+      std::cerr << "monitor: " << error << "\n";
+      return 1;
+    }
+    player.KeepHistory(std::chrono::minutes(options.history_minutes));
+    NCursesDisplay::Display(player, options.top, options.columns);
+    return 0;
+  }
+  System system(options.threads, options.netlink
+                                     ? ProcessDiscovery::Backend::kNetlink
+                                     : ProcessDiscovery::Backend::kScan);
+  if (options.netlink &&
+      system.Discovery() != ProcessDiscovery::Backend::kNetlink) {
+    std::cerr << "monitor: proc connector unavailable, scanning /proc\n";
+  }
+  system.SetFilter(filter);
+  if (!options.record.empty()) {
+    if (!Recording::Run(system, options.record, options.interval_ms,
+                        options.count, options.top, error)) {
+      std::cerr << "monitor: " << error << "\n";
+      return 1;
+    }
+  } else if (!options.listen.empty()) {
+    // Scrapes render the latest snapshot; only the files behind the
+    // exported process series are read
+    MetricsServer server;
+    if (!server.Listen(options.listen, error)) {
+      std::cerr << "monitor: " << error << "\n";
+      return 1;
+    }
+    system.TopN(options.top);
+    system.Collect(Columns::Sources({Columns::Id::kPid, Columns::Id::kUser,
+                                     Columns::Id::kCpu, Columns::Id::kRam,
+                                     Columns::Id::kCommand}));
+    Collector collector(
+        system,
+        RefreshScheduler(std::chrono::milliseconds(options.interval_ms),
+                         options.budget_percent / 100));
+    server.Serve(collector);
+  } else if (options.batch) {
+    NdjsonOutput::Run(system, options.interval_ms, options.count, options.top,
+                      options.self_stats, options.columns, options.groups);
+  } else {
+    // The display refreshes about once per interval, as often as the CPU
+    // budget allows. The history is sized for the shortest interval and
+    // trimmed by age, so it spans the same minutes at any pace.
+    const RefreshScheduler scheduler(
+        std::chrono::milliseconds(options.interval_ms),
+        options.budget_percent / 100);
+    system.KeepHistory(std::chrono::minutes(options.history_minutes),
+                       scheduler.Shortest());
+    NCursesDisplay::Display(system, options.top, options.columns, scheduler);
+  }
+}
@@ -0,0 +1,187 @@
+#include "metrics_server.h"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "open_metrics.h"
+
+using std::string;
+
+namespace {
+// Time a client gets to send its request and to take the response
+constexpr std::chrono::seconds kClientTimeout{2};
+
+// Longest request head read; anything longer is refused
+constexpr std::size_t kMaxRequest{8192};
+
+constexpr int kBacklog{16};
+
+// Split host:port, [host]:port or :port; an empty host means every address
+bool SplitAddress(const string& address, string& host, string& port) {
+  const auto colon = address.rfind(':');
+  if (colon == string::npos || colon + 1 == address.size()) {
+    return false;
+  }
+  host = address.substr(0, colon);
+  port = address.substr(colon + 1);
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+  return true;
+}
+
+// Send all of data unless the client goes away or times out
+void SendAll(int client, const string& data) {
+  std::size_t sent{0};
+  while (sent < data.size()) {
+    const ssize_t n =
+        send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    sent += static_cast<std::size_t>(n);
+  }
+}
+}  // namespace
+
+MetricsServer::~MetricsServer() {
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+}
+
+// Bind and listen on address, given as host:port or :port
+bool MetricsServer::Listen(const string& address, string& error) {
+  string host;
+  string port;
+  if (!SplitAddress(address, host, port)) {
+    error = "invalid listen address: " + address;
+    return false;
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo* addresses = nullptr;
+  const int status = getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                                 port.c_str(), &hints, &addresses);
+  if (status != 0) {
+    error = "cannot resolve " + address + ": " + gai_strerror(status);
+    return false;
+  }
+  int failure{0};
+  for (const addrinfo* ai = addresses; ai != nullptr; ai = ai->ai_next) {
+    const int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                          ai->ai_protocol);
+    if (fd < 0) {
+      failure = errno;
+      continue;
+    }
+    const int on{1};
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 &&
+        listen(fd, kBacklog) == 0) {
+      socket_ = fd;
+      break;
+    }
+    failure = errno;
+    close(fd);
+  }
+  freeaddrinfo(addresses);
+  if (socket_ < 0) {
+    error = "cannot listen on " + address + ": " + std::strerror(failure);
+    return false;
+  }
+  return true;
+}
+
+// Answer requests forever
+void MetricsServer::Serve(SnapshotSource& source) {
+  timeval timeout{};
+  timeout.tv_sec = kClientTimeout.count();
+  while (true) {
+    const int client = accept4(socket_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) {
+      // Out of descriptors or the like; give the system a moment
+      if (errno != EINTR && errno != ECONNABORTED) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      continue;
+    }
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    Answer(client, source);
+    close(client);
+  }
+}
+
+// Read one request and write its response. Only GET and HEAD of /metrics
+// are served.
+void MetricsServer::Answer(int client, SnapshotSource& source) {
+  request_.clear();
+  char buffer[1024];
+  while (request_.find("\r\n\r\n") == string::npos) {
+    if (request_.size() > kMaxRequest) {
+      return;
+    }
+    const ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    request_.append(buffer, n);
+  }
+  const auto method_end = request_.find(' ');
+  const auto path_end = request_.find_first_of(" ?", method_end + 1);
+  const string method = request_.substr(0, method_end);
+  const string path =
+      method_end == string::npos
+          ? string()
+          : request_.substr(method_end + 1, path_end - method_end - 1);
+
+  string status{"200 OK"};
+  const string* body = &body_;
+  string message;
+  if (method != "GET" && method != "HEAD") {
+    status = "405 Method Not Allowed";
+  } else if (path != "/metrics") {
+    status = "404 Not Found";
+  } else {
+    // Render once per snapshot; scrapes in between share the text
+    source.Update();
+    const Snapshot& snapshot = source.Current();
+    if (snapshot.sequence == 0) {
+      status = "503 Service Unavailable";
+    } else if (snapshot.sequence != sequence_) {
+      sequence_ = snapshot.sequence;
+      body_.clear();
+      OpenMetrics::AppendSnapshot(snapshot, body_);
+    }
+  }
+  const bool metrics{status[0] == '2'};
+  if (!metrics) {
+    message = status + "\n";
+    body = &message;
+  }
+  response_ = "HTTP/1.1 " + status + "\r\nContent-Type: ";
+  response_ += metrics ? OpenMetrics::kContentType : "text/plain";
+  response_ += "\r\nContent-Length: " + std::to_string(body->size()) +
+               "\r\nConnection: close\r\n\r\n";
+  if (method != "HEAD") {
+    response_ += *body;
+  }
+  SendAll(client, response_);
+}
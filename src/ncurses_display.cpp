@@ -2,12 +2,23 @@
 
 #include <curses.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
 #include <string>
-#include <thread>
 #include <vector>
 
+#include "collector.h"
+#include "columns.h"
+#include "filter.h"
 #include "format.h"
+#include "history.h"
+#include "instrumentation.h"
+#include "linux_parser.h"
+#include "snapshot.h"
+#include "snapshot_source.h"
 #include "system.h"
 
 using std::string;
@@ -30,83 +41,786 @@ std::string NCursesDisplay::ProgressBar(float percent) {
   return result + " " + display + "/100%";
 }
 
-void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
+// Width of the bar inside a per-core cell such as " 12[|||       ]"
+constexpr int kCoreBarWidth{10};
+constexpr int kCoreCellWidth{kCoreBarWidth + 6};
+
+// Width of a pressure gauge such as "memory[||        ]  12.5%" and its gap
+constexpr int kPressureCellWidth{kCoreBarWidth + 18};
+
+// Compact bar for a single CPU, one bar (|) per 10%
+std::string NCursesDisplay::CoreBar(int core, float percent) {
+  string label{to_string(core)};
+  std::string result(3 - std::min<int>(3, label.size()), ' ');
+  result += label + "[";
+  const float bars{percent * kCoreBarWidth};
+  for (int i{0}; i < kCoreBarWidth; ++i) {
+    result += i < bars ? '|' : ' ';
+  }
+  return result + "]";
+}
+
+// Levels of a sparkline cell, from no sample or zero up to full scale
+constexpr char kSparkLevels[]{" .:-=+*#%@"};
+constexpr int kSparkTop{sizeof(kSparkLevels) - 2};
+
+// Sparkline of fixed-point samples (History::kScale is full scale) that fits
+// a whole history of length samples into width cells. Each cell shows the
+// peak of its share of samples, and the newest sample is on the right.
+std::string NCursesDisplay::Sparkline(const std::vector<std::uint16_t>& samples,
+                                      std::size_t length, int width) {
+  std::string result(std::max(0, width), ' ');
+  if (width <= 0) {
+    return result;
+  }
+  const std::size_t bucket{
+      std::max<std::size_t>(1, (length + width - 1) / width)};
+  std::size_t end{samples.size()};
+  for (int cell = width - 1; cell >= 0 && end > 0; --cell) {
+    const std::size_t begin{end > bucket ? end - bucket : 0};
+    const std::uint16_t peak{
+        *std::max_element(samples.begin() + begin, samples.begin() + end)};
+    if (peak > 0) {
+      result[cell] = kSparkLevels[1 + peak * (kSparkTop - 1) / History::kScale];
+    }
+    end = begin;
+  }
+  return result;
+}
+
+// The CPU or memory bar with the bars replaced by the history
+std::string NCursesDisplay::HistoryBar(
+    float percent, const std::vector<std::uint16_t>& samples,
+    std::size_t length) {
+  std::string result{ProgressBar(percent)};
+  return result.replace(2, 50, Sparkline(samples, length, 50));
+}
+
+// A per-core cell with the bar replaced by the history
+std::string NCursesDisplay::CoreSparkline(
+    int core, const std::vector<std::uint16_t>& samples,
+    std::size_t length) {
+  std::string result{CoreBar(core, 0)};
+  return result.replace(result.size() - kCoreBarWidth - 1, kCoreBarWidth,
+                        Sparkline(samples, length, kCoreBarWidth));
+}
+
+// Number of rows needed to show one bar per core in a window of this width
+int NCursesDisplay::CoreRows(int cores, int width) {
+  const int per_row{std::max(1, (width - 4) / kCoreCellWidth)};
+  return (cores + per_row - 1) / per_row;
+}
+
+NCursesDisplay::Panel::Panel(int height, int width, int y, int x)
+    : window_(newwin(height, width, y, x)),
+      height_(height),
+      width_(width),
+      cells_(height * width, 0) {}
+
+NCursesDisplay::Panel::~Panel() { delwin(window_); }
+
+// Draw text padded with blanks to width, clipped at the right border. Only
+// the span between the first and the last changed cell is written.
+void NCursesDisplay::Panel::Put(int row, int column, int width,
+                                const string& text, attr_t attributes) {
+  width = std::min(width, width_ - 1 - column);
+  if (row < 0 || row >= height_ || column < 0 || width <= 0) {
+    return;
+  }
+  line_.assign(width, ' ');
+  line_.replace(0, std::min<std::size_t>(text.size(), width), text, 0,
+                width);
+  chtype* cells = &cells_[row * width_ + column];
+  int first{-1};
+  int last{-1};
+  for (int i = 0; i < width; ++i) {
+    const chtype cell = static_cast<unsigned char>(line_[i]) | attributes;
+    if (cells[i] != cell) {
+      cells[i] = cell;
+      if (first < 0) {
+        first = i;
+      }
+      last = i;
+    }
+  }
+  if (first < 0) {
+    return;
+  }
+  wattrset(window_, attributes);
+  mvwaddnstr(window_, row, column + first, line_.data() + first,
+             last - first + 1);
+  wattrset(window_, A_NORMAL);
+}
+
+// The row was drawn outside Put(), so its next Put() must write everything
+void NCursesDisplay::Panel::Forget(int row) {
+  std::fill_n(cells_.begin() + row * width_, width_, 0);
+}
+
+// Blank the whole window, border included, and forget what it showed
+void NCursesDisplay::Panel::Clear() {
+  werase(window_);
+  std::fill(cells_.begin(), cells_.end(), 0);
+}
+
+void NCursesDisplay::Panel::Stage() { wnoutrefresh(window_); }
+
+// Write every staged panel to the terminal and return the bytes it took
+long NCursesDisplay::Flush() {
+  const long before = LinuxParser::WrittenBytes();
+  doupdate();
+  return LinuxParser::WrittenBytes() - before;
+}
+
+// Border, labels and the values that never change, drawn once
+void NCursesDisplay::SetupSystem(const Snapshot& snapshot, Panel& panel) {
+  WINDOW* window = panel.Window();
+  const int core_rows{CoreRows(snapshot.cores.size(), panel.Width())};
+  box(window, 0, 0);
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
+  mvwprintw(window, ++row, 2, "OS: %s", snapshot.operating_system.c_str());
+  mvwprintw(window, ++row, 2, "Kernel: %s", snapshot.kernel.c_str());
   mvwprintw(window, ++row, 2, "CPU: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, " ");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
   mvwprintw(window, ++row, 2, "Memory: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
-  wrefresh(window);
-}
-
-void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+  row += core_rows;
+  mvwprintw(window, ++row, 2, "Total Processes: ");
+  mvwprintw(window, ++row, 2, "Running Processes: ");
+  mvwprintw(window, ++row, 2, "Up Time: ");
+  mvwprintw(window, ++row, 2, "Load Average: ");
+  mvwprintw(window, ++row, 2, "Breakdown: ");
+  mvwprintw(window, ++row, 2, "Paging: ");
+  mvwprintw(window, ++row, 2, "Pressure: ");
+}
+
+void NCursesDisplay::SetupProcesses(Panel& panel) {
+  box(panel.Window(), 0, 0);
+}
+
+// With history set, the bars show the history of each value instead of its
+// current level
+void NCursesDisplay::DisplaySystem(const Snapshot& snapshot, Panel& panel,
+                                   bool history) {
+  MONITOR_TIME_PHASE(kRenderSystem);
+  const int width{panel.Width()};
+  const std::size_t length{snapshot.history_length};
+  int row{2};
+  panel.Put(++row, 10, width,
+            " " + (history ? HistoryBar(snapshot.cpu, snapshot.cpu_history,
+                                        length)
+                           : ProgressBar(snapshot.cpu)),
+            COLOR_PAIR(1));
+  panel.Put(++row, 10, width,
+            history ? HistoryBar(snapshot.memory, snapshot.memory_history,
+                                 length)
+                    : ProgressBar(snapshot.memory),
+            COLOR_PAIR(1));
+  const auto& cores = snapshot.cores;
+  const int per_row{std::max(1, (width - 4) / kCoreCellWidth)};
+  for (std::size_t i = 0; i < cores.size(); ++i) {
+    const int column = i % per_row;
+    if (column == 0) {
+      ++row;
+    }
+    const bool core_history{history && i < snapshot.core_history.size()};
+    panel.Put(row, 2 + column * kCoreCellWidth, kCoreCellWidth,
+              core_history
+                  ? CoreSparkline(i, snapshot.core_history[i], length)
+                  : CoreBar(i, cores[i]),
+              COLOR_PAIR(1));
+  }
+  panel.Put(++row, 19, width, to_string(snapshot.total_processes));
+  panel.Put(++row, 21, width, to_string(snapshot.running_processes));
+  panel.Put(++row, 11, width, Format::ElapsedTime(snapshot.uptime));
+  char load[48];
+  const float* average = snapshot.load_average;
+  std::snprintf(load, sizeof(load), "%.2f %.2f %.2f", average[0], average[1],
+                average[2]);
+  panel.Put(++row, 16, width, load);
+  panel.Put(++row, 13, width, MemoryLine(snapshot.meminfo));
+  char paging[96];
+  std::snprintf(paging, sizeof(paging),
+                "faults %.0f/s major %.0f/s swap in %.0f/s out %.0f/s",
+                snapshot.page_faults, snapshot.major_faults,
+                snapshot.swap_ins, snapshot.swap_outs);
+  panel.Put(++row, 10, width, paging);
+  if (!snapshot.has_pressure) {
+    panel.Put(++row, 12, width, "not available");
+    return;
+  }
+  static const char* const kResources[]{"cpu", "memory", "io"};
+  ++row;
+  for (int i = 0; i < LinuxParser::kPressureResources; ++i) {
+    panel.Put(row, 12 + i * kPressureCellWidth, kPressureCellWidth,
+              PressureGauge(kResources[i], snapshot.pressure[i].some[0]),
+              COLOR_PAIR(1));
+  }
+}
+
+// Used and available memory, then where the rest of it went
+std::string NCursesDisplay::MemoryLine(const LinuxParser::MemInfo& meminfo) {
+  auto kb = [](long kilobytes) { return Format::Bytes(kilobytes * 1024.0); };
+  char line[160];
+  std::snprintf(
+      line, sizeof(line),
+      "used %s avail %s buffers %s cached %s slab %s dirty %s swap %s/%s",
+      kb(meminfo.total - meminfo.available).c_str(),
+      kb(meminfo.available).c_str(), kb(meminfo.buffers).c_str(),
+      kb(meminfo.cached).c_str(), kb(meminfo.slab).c_str(),
+      kb(meminfo.dirty).c_str(),
+      kb(meminfo.swap_total - meminfo.swap_free).c_str(),
+      kb(meminfo.swap_total).c_str());
+  return line;
+}
+
+// Share of the last 10 seconds some task stalled on a resource, one bar (|)
+// per 10%
+std::string NCursesDisplay::PressureGauge(const char* resource,
+                                          float percent) {
+  std::string result{resource};
+  result += "[";
+  for (int i{0}; i < kCoreBarWidth; ++i) {
+    result += i < percent / 10 ? '|' : ' ';
+  }
+  char value[16];
+  std::snprintf(value, sizeof(value), "] %5.1f%%", percent);
+  return result + value;
+}
+
+// How long the render loop waits for a keystroke before checking for a new
+// snapshot, in milliseconds
+constexpr int kInputTimeout{50};
+
+// Map a keystroke to the sort key it selects
+bool NCursesDisplay::SortKeyFor(int key, SortKey& sort_key) {
+  switch (key) {
+    case 'c':
+      sort_key = SortKey::kCpu;
+      return true;
+    case 'm':
+      sort_key = SortKey::kRam;
+      return true;
+    case 't':
+      sort_key = SortKey::kUpTime;
+      return true;
+    case 'p':
+      sort_key = SortKey::kPid;
+      return true;
+    case 'u':
+      sort_key = SortKey::kUser;
+      return true;
+  }
+  return false;
+}
+
+// The row at index selected, if any, is shown in reverse video. With
+// threads set, the threads of the selected process follow it; processes
+// above it scroll away if they would not fit. Columns are laid out from the
+// registry in the order given.
+void NCursesDisplay::DisplayProcesses(const Snapshot& snapshot, Panel& panel,
+                                      int n, int selected, bool threads,
+                                      const std::vector<Columns::Id>& columns) {
+  MONITOR_TIME_PHASE(kRenderProcesses);
   int row{0};
-  int const pid_column{2};
-  int const user_column{9};
-  int const cpu_column{18};
-  int const ram_column{27};
-  int const time_column{35};
-  int const command_column{46};
-  wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
-  mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
-  mvwprintw(window, row, command_column, "COMMAND");
-  wattroff(window, COLOR_PAIR(2));
+  int const first_column{2};
+  // Each cell runs up to the next column; the last one to the border
+  auto cells = [&](auto&& cell, attr_t attributes) {
+    panel.Put(++row, 1, first_column - 1, "", attributes);
+    int column{first_column};
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      const int width{i + 1 < columns.size() ? Columns::Get(columns[i]).width
+                                             : panel.Width()};
+      panel.Put(row, column, width, cell(columns[i]), attributes);
+      column += width;
+    }
+  };
+  // The header of the sort column is shown in reverse video
+  ++row;
+  int column{first_column};
+  for (const auto id : columns) {
+    const Columns::Column& info = Columns::Get(id);
+    const string title{info.title};
+    const attr_t reverse = info.sortable && info.sort_key == snapshot.sort_key
+                               ? A_REVERSE
+                               : A_NORMAL;
+    panel.Put(row, column, title.size(), title, COLOR_PAIR(2) | reverse);
+    column += info.width;
+  }
+  // Columns read lazily show '-' until their first reading
+  auto megabytes = [](long kb) {
+    return kb < 0 ? string("-") : to_string(kb / 1024);
+  };
+  auto rate = [](float bytes) {
+    return bytes < 0 ? string("-") : Format::Bytes(bytes);
+  };
+  const auto& processes = snapshot.processes;
   int const num_processes = int(processes.size()) > n ? n : processes.size();
-  for (int i = 0; i < num_processes; ++i) {
-    mvwprintw(window, ++row, pid_column, to_string(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
+  int num_threads{0};
+  int first{0};
+  if (threads && selected >= 0 && selected < num_processes &&
+      processes[selected].pid == snapshot.threads_pid) {
+    num_threads = std::min<int>(snapshot.threads.size(), n - 1);
+    first = std::max(0, selected + 1 + num_threads - n);
+  }
+  auto process_row = [&](int i) {
+    const ProcessRow& process = processes[i];
+    cells(
+        [&](Columns::Id id) -> string {
+          switch (id) {
+            case Columns::Id::kPid:
+              return to_string(process.pid);
+            case Columns::Id::kUser:
+              return process.user;
+            case Columns::Id::kCpu:
+              return to_string(process.cpu * 100).substr(0, 4);
+            case Columns::Id::kRam:
+              return to_string(process.ram_kb / 1024);
+            case Columns::Id::kPss:
+              return megabytes(process.pss_kb);
+            case Columns::Id::kSwap:
+              return megabytes(process.swap_kb);
+            case Columns::Id::kRead:
+              return rate(process.read_rate);
+            case Columns::Id::kWrite:
+              return rate(process.write_rate);
+            case Columns::Id::kFaults:
+              return to_string(std::lround(process.major_fault_rate));
+            case Columns::Id::kTime:
+              return Format::ElapsedTime(process.uptime);
+            case Columns::Id::kCommand:
+              return process.command;
+          }
+          return {};
+        },
+        i == selected ? A_REVERSE : A_NORMAL);
+  };
+  // Threads show their ID, state and name; memory belongs to the process
+  auto thread_row = [&](const ThreadRow& thread) {
+    cells(
+        [&](Columns::Id id) -> string {
+          switch (id) {
+            case Columns::Id::kPid:
+              return to_string(thread.tid);
+            case Columns::Id::kUser:
+              return string(1, thread.state);
+            case Columns::Id::kCpu:
+              return to_string(thread.cpu * 100).substr(0, 4);
+            case Columns::Id::kTime:
+              return Format::ElapsedTime(thread.uptime);
+            case Columns::Id::kCommand:
+              return " `- " + thread.name;
+            default:
+              return {};
+          }
+        },
+        A_NORMAL);
+  };
+  int shown{0};
+  for (int i = first; i < num_processes && shown < n; ++i, ++shown) {
+    process_row(i);
+    if (i == selected) {
+      for (int t = 0; t < num_threads && shown + 1 < n; ++t, ++shown) {
+        thread_row(snapshot.threads[t]);
+      }
+    }
+  }
+  // Blank the rows a shorter list no longer uses
+  for (int i = shown; i < n; ++i) {
+    panel.Put(++row, 1, panel.Width(), "");
+  }
+}
+
+// Rows of cgroups or users in place of the process list, with the same sort
+// keys: CPU and memory order by the largest, the others by name
+void NCursesDisplay::DisplayGroups(const std::vector<GroupRow>& groups,
+                                   const char* title, SortKey sort_key,
+                                   Panel& panel, int n) {
+  MONITOR_TIME_PHASE(kRenderProcesses);
+  int row{0};
+  int const count_column{2};
+  int const cpu_column{9};
+  int const ram_column{18};
+  int const name_column{27};
+  const bool by_name{sort_key != SortKey::kCpu && sort_key != SortKey::kRam};
+  auto header = [&](int column, const string& title, bool sorted) {
+    const attr_t reverse = sorted ? A_REVERSE : A_NORMAL;
+    panel.Put(row, column, title.size(), title, COLOR_PAIR(2) | reverse);
+  };
+  ++row;
+  header(count_column, "PROCS", false);
+  header(cpu_column, "CPU[%]", sort_key == SortKey::kCpu);
+  header(ram_column, "RAM[MB]", sort_key == SortKey::kRam);
+  header(name_column, title, by_name);
+  int const num_groups = std::min<int>(n, groups.size());
+  for (int i = 0; i < num_groups; ++i) {
+    const GroupRow& group = groups[i];
+    panel.Put(++row, count_column, cpu_column - count_column,
+              to_string(group.processes));
+    panel.Put(row, cpu_column, ram_column - cpu_column,
+              to_string(group.cpu * 100).substr(0, 4));
+    panel.Put(row, ram_column, name_column - ram_column,
+              to_string(group.ram_kb / 1024));
+    panel.Put(row, name_column, panel.Width(), group.name);
+  }
+  for (int i = num_groups; i < n; ++i) {
+    panel.Put(++row, 1, panel.Width(), "");
+  }
+}
+
+// History of one process: its CPU utilization and its resident memory, the
+// latter scaled to its peak
+void NCursesDisplay::DisplayDetail(const ProcessRow& process, Panel& panel,
+                                   std::size_t length) {
+  const int width{panel.Width()};
+  const int spark_width{std::max(10, width - 40)};
+  char text[64];
+  panel.Put(1, 2, width,
+            "PID " + to_string(process.pid) + " " + process.user + " " +
+                process.command,
+            COLOR_PAIR(2));
+
+  std::uint16_t cpu_peak{0};
+  for (const auto sample : process.cpu_history) {
+    cpu_peak = std::max(cpu_peak, sample);
+  }
+  panel.Put(2, 2, 5, "CPU");
+  panel.Put(2, 7, spark_width,
+            Sparkline(process.cpu_history, length, spark_width),
+            COLOR_PAIR(1));
+  std::snprintf(text, sizeof(text), " now %5.1f%% peak %5.1f%%",
+                process.cpu * 100, cpu_peak * 100.0 / History::kScale);
+  panel.Put(2, 7 + spark_width, width, text);
+
+  std::uint32_t rss_peak{1};
+  for (const auto sample : process.rss_history) {
+    rss_peak = std::max(rss_peak, sample);
   }
+  std::vector<std::uint16_t> rss(process.rss_history.size());
+  for (std::size_t i = 0; i < rss.size(); ++i) {
+    rss[i] = std::uint64_t{process.rss_history[i]} * History::kScale / rss_peak;
+  }
+  panel.Put(3, 2, 5, "RAM");
+  panel.Put(3, 7, spark_width, Sparkline(rss, length, spark_width),
+            COLOR_PAIR(1));
+  std::snprintf(text, sizeof(text), " now %6ld MB peak %6lu MB",
+                process.ram_kb / 1024,
+                static_cast<unsigned long>(
+                    process.rss_history.empty() ? 0 : rss_peak / 1024));
+  panel.Put(3, 7 + spark_width, width, text);
+}
+
+// One line summary of the monitor's own cost during a tick
+std::string NCursesDisplay::CostLine(const Instrumentation::Tick& tick,
+                                     long terminal_bytes) {
+  char line[192];
+  std::snprintf(
+      line, sizeof(line),
+      " scan %.1fms parse %.1fms sort %.2fms render %.2f+%.2fms | opens %llu "
+      "reads %llu read %.1fKB | tty %ldB ",
+      tick.phase_ns[Instrumentation::kScan] / 1e6,
+      tick.phase_ns[Instrumentation::kParse] / 1e6,
+      tick.phase_ns[Instrumentation::kSort] / 1e6,
+      tick.phase_ns[Instrumentation::kRenderSystem] / 1e6,
+      tick.phase_ns[Instrumentation::kRenderProcesses] / 1e6,
+      static_cast<unsigned long long>(tick.counters[Instrumentation::kOpens]),
+      static_cast<unsigned long long>(tick.counters[Instrumentation::kReads]),
+      tick.counters[Instrumentation::kBytesRead] / 1024.0, terminal_bytes);
+  return line;
 }
 
-void NCursesDisplay::Display(System& system, int n) {
+// Height of the per-process detail pane, borders included
+constexpr int kDetailHeight{5};
+
+// Width of the status of the snapshot source in the top border
+constexpr int kStatusWidth{48};
+
+// Key code of the escape key
+constexpr int kEscape{27};
+
+// Collection runs on a Collector thread; the display only draws its latest
+// snapshot and polls the keyboard, so it stays responsive however long a
+// refresh takes. The scheduler sets the pace of the refreshes.
+void NCursesDisplay::Display(System& system, int n,
+                             const std::vector<Columns::Id>& columns,
+                             const RefreshScheduler& scheduler) {
+  system.TopN(n);
+  system.Collect(Columns::Sources(columns));
+  Collector collector(system, scheduler);
+  Display(collector, n, columns);
+}
+
+// Draw the snapshots of source until 'q' is pressed. Each frame writes only
+// the cells that changed.
+void NCursesDisplay::Display(SnapshotSource& source, int n,
+                             const std::vector<Columns::Id>& columns) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  keypad(stdscr, TRUE);
+  timeout(kInputTimeout);
+  refresh();
+
+  std::unique_ptr<Panel> system_panel;
+  std::unique_ptr<Panel> process_panel;
+  std::unique_ptr<Panel> detail_panel;
+
+  // The cost of the monitor itself is shown in the bottom border of the
+  // process window, toggled with 'i', together with the bytes the previous
+  // frame wrote to the terminal and the pace the scheduler chose
+  bool show_cost{false};
+  long frame_bytes{0};
+  auto draw_cost = [&](const Snapshot& snapshot) {
+    const int row{process_panel->Height() - 1};
+    if (show_cost) {
+      string line{CostLine(snapshot.cost, frame_bytes)};
+      if (snapshot.interval_ms > 0) {
+        char pace[64];
+        std::snprintf(pace, sizeof(pace), " cpu %.1f%% every %ldms |",
+                      snapshot.self_cpu * 100, snapshot.interval_ms);
+        line.insert(0, pace);
+      }
+      process_panel->Put(row, 2, process_panel->Width(), line);
+    } else {
+      process_panel->Forget(row);
+      mvwhline(process_panel->Window(), row, 1, ACS_HLINE,
+               process_panel->Width() - 2);
+    }
+  };
+
+  // '/' edits the process filter in the bottom border; Enter applies it, an
+  // empty one shows every process again, and Escape leaves it as it was. The
+  // active filter, or why one was refused, is shown in the top border.
+  bool editing{false};
+  string filter_text;
+  string filter_error;
+  string filter_line;
+  auto draw_filter = [&](const Snapshot& snapshot) {
+    string line{filter_error};
+    if (line.empty() && !snapshot.filter.empty()) {
+      line = "filter: " + snapshot.filter + " (" +
+             to_string(snapshot.matches) + " matched)";
+    }
+    if (line == filter_line) {
+      return;
+    }
+    filter_line = line;
+    process_panel->Forget(0);
+    mvwhline(process_panel->Window(), 0, 1, ACS_HLINE,
+             process_panel->Width() - 2);
+    if (!line.empty()) {
+      process_panel->Put(0, 2, line.size() + 2, " " + line + " ");
+    }
+  };
+  auto draw_prompt = [&] {
+    process_panel->Put(process_panel->Height() - 1, 2,
+                       process_panel->Width() - 4, " /" + filter_text + "_ ");
+  };
+
+  // 'h' switches the bars to history; 'd' opens the detail pane of the
+  // selected process, which the arrow keys move, and 'e' expands it into its
+  // threads. The selection follows its PID when the list is re-sorted.
+  bool show_history{false};
+  bool show_detail{false};
+  bool show_threads{false};
+  int threads_pid{-1};
+  int selected_pid{-1};
+  auto selected_row = [&](const Snapshot& snapshot) {
+    const int rows = std::min<int>(n, snapshot.processes.size());
+    for (int i = 0; i < rows; ++i) {
+      if (snapshot.processes[i].pid == selected_pid) {
+        return i;
+      }
+    }
+    return rows > 0 ? 0 : -1;
+  };
+  // 'g' cycles the process list through the rollups by cgroup and by user;
+  // the detail pane only applies to processes
+  enum class View { kProcesses, kCgroups, kUsers };
+  View view{View::kProcesses};
+  // Blank the detail pane, then uncover whatever it was drawn over
+  auto hide_detail = [&] {
+    show_detail = false;
+    touchwin(stdscr);
+    wnoutrefresh(stdscr);
+    touchwin(system_panel->Window());
+    touchwin(process_panel->Window());
+  };
+  // The source reads only what the columns and the open views show
+  unsigned sources{Columns::Sources(columns)};
+  auto draw = [&](const Snapshot& snapshot) {
+    unsigned needed{Columns::Sources(columns)};
+    if (view != View::kProcesses) {
+      needed |= Columns::kGroupSources;
+    }
+    if (show_detail) {
+      needed |= Columns::kStatus | Columns::kCmdline;
+    }
+    if (needed != sources) {
+      sources = needed;
+      source.Collect(sources);
+    }
+    const int selected{(show_detail || show_threads) &&
+                               view == View::kProcesses
+                           ? selected_row(snapshot)
+                           : -1};
+    // Threads are only collected for the process they are shown for
+    const int pid{show_threads && selected >= 0
+                      ? snapshot.processes[selected].pid
+                      : -1};
+    if (pid != threads_pid) {
+      threads_pid = pid;
+      source.ShowThreads(pid);
+    }
+    DisplaySystem(snapshot, *system_panel, show_history);
+    const string status{source.Status()};
+    if (!status.empty()) {
+      system_panel->Put(0, 2, kStatusWidth, " " + status + " ");
+    }
+    switch (view) {
+      case View::kProcesses:
+        DisplayProcesses(snapshot, *process_panel, n, selected,
+                         show_threads, columns);
+        break;
+      case View::kCgroups:
+        DisplayGroups(snapshot.cgroups, "CGROUP", snapshot.sort_key,
+                      *process_panel, n);
+        break;
+      case View::kUsers:
+        DisplayGroups(snapshot.users, "USER", snapshot.sort_key,
+                      *process_panel, n);
+        break;
+    }
+    draw_filter(snapshot);
+    if (editing) {
+      draw_prompt();
+    } else if (show_cost) {
+      draw_cost(snapshot);
+    }
+    system_panel->Stage();
+    process_panel->Stage();
+    if (show_detail && selected >= 0) {
+      DisplayDetail(snapshot.processes[selected], *detail_panel,
+                    snapshot.history_length);
+      // Staging the windows below may have covered part of the pane
+      touchwin(detail_panel->Window());
+      detail_panel->Stage();
+    }
+    frame_bytes = Flush();
+  };
+
+  auto edit_filter = [&](int key) {
+    if (key == '\n' || key == KEY_ENTER) {
+      Filter filter;
+      editing = false;
+      if (!filter.Compile(filter_text, filter_error)) {
+        filter_error = "filter: " + filter_error;
+      } else if (!source.SetFilter(filter)) {
+        filter_error = "filter: not available for this source";
+      } else {
+        filter_error.clear();
+      }
+    } else if (key == kEscape) {
+      editing = false;
+    } else if (key == KEY_BACKSPACE || key == 127 || key == '\b') {
+      if (!filter_text.empty()) {
+        filter_text.pop_back();
+      }
+    } else if (key >= ' ' && key < 127) {
+      filter_text += static_cast<char>(key);
+    }
+    if (!editing) {
+      draw_cost(source.Current());
+    }
+    draw(source.Current());
+  };
+
+  bool running{true};
+  while (running) {
+    if (source.Update()) {
+      const Snapshot& snapshot = source.Current();
+      if (!system_panel) {
+        // The layout depends on the number of cores, known from now on. The
+        // detail pane goes below the process list, or over its last rows
+        // when the terminal is too short.
+        const int width{getmaxx(stdscr) - 1};
+        const int core_rows{CoreRows(snapshot.cores.size(), width)};
+        system_panel = std::make_unique<Panel>(13 + core_rows, width, 0, 0);
+        process_panel =
+            std::make_unique<Panel>(3 + n, width, system_panel->Height(), 0);
+        const int detail_y{
+            std::min(system_panel->Height() + process_panel->Height(),
+                     std::max(0, getmaxy(stdscr) - kDetailHeight))};
+        detail_panel =
+            std::make_unique<Panel>(kDetailHeight, width, detail_y, 0);
+        SetupSystem(snapshot, *system_panel);
+        SetupProcesses(*process_panel);
+        SetupProcesses(*detail_panel);
+      }
+      draw(snapshot);
+    }
 
-  int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
-
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const int key = getch();
+    SortKey sort_key;
+    if (key == 'q') {
+      running = false;
+    } else if (!process_panel || key == ERR) {
+      continue;
+    } else if (editing) {
+      edit_filter(key);
+    } else if (key == '/') {
+      editing = true;
+      filter_text = source.Current().filter;
+      draw(source.Current());
+    } else if (source.HandleKey(key)) {
+      continue;
+    } else if (key == 'i' && Instrumentation::kEnabled) {
+      show_cost = !show_cost;
+      draw_cost(source.Current());
+      draw(source.Current());
+    } else if (key == 'h') {
+      show_history = !show_history;
+      draw(source.Current());
+    } else if (key == 'g') {
+      view = view == View::kProcesses ? View::kCgroups
+             : view == View::kCgroups ? View::kUsers
+                                      : View::kProcesses;
+      if (show_detail) {
+        hide_detail();
+      }
+      // The columns differ between views, so start from a blank window
+      process_panel->Clear();
+      SetupProcesses(*process_panel);
+      filter_line.clear();
+      draw_cost(source.Current());
+      draw(source.Current());
+    } else if (key == 'd' && view == View::kProcesses) {
+      if (show_detail) {
+        hide_detail();
+      } else {
+        show_detail = true;
+      }
+      draw(source.Current());
+    } else if (key == 'e' && view == View::kProcesses) {
+      show_threads = !show_threads;
+      draw(source.Current());
+    } else if ((key == KEY_UP || key == KEY_DOWN) &&
+               view == View::kProcesses) {
+      const Snapshot& snapshot = source.Current();
+      const int rows = std::min<int>(n, snapshot.processes.size());
+      int row{selected_row(snapshot) + (key == KEY_UP ? -1 : 1)};
+      row = std::max(0, std::min(rows - 1, row));
+      if (row >= 0) {
+        selected_pid = snapshot.processes[row].pid;
+        draw(snapshot);
+      }
+    } else if (SortKeyFor(key, sort_key)) {
+      source.SortBy(sort_key);
+    }
   }
+  detail_panel.reset();
+  process_panel.reset();
+  system_panel.reset();
   endwin();
 }
@@ -0,0 +1,432 @@
+#include "ndjson_output.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "columns.h"
+#include "snapshot.h"
+#include "system.h"
+#include "watcher.h"
+
+using std::string;
+
+namespace {
+// Initial capacity of the output buffer; it only grows if a record with
+// unusually long command lines does not fit
+constexpr std::size_t kBufferSize{64 * 1024};
+
+// Append a number without going through a temporary string
+template <typename T>
+void AppendNumber(T value, string& out) {
+  char buffer[32];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr);
+}
+
+// Append a value that is negative when unknown, or null
+template <typename T>
+void AppendKnown(T value, string& out) {
+  if (value < 0) {
+    out += "null";
+  } else {
+    AppendNumber(value, out);
+  }
+}
+
+void AppendKey(const char* key, string& out) {
+  out += '"';
+  out += key;
+  out += "\":";
+}
+
+// Append the memory breakdown in kB as a JSON object
+void AppendMemInfo(const LinuxParser::MemInfo& meminfo, string& out) {
+  const std::pair<const char*, long> fields[]{
+      {"total_kb", meminfo.total},
+      {"free_kb", meminfo.free},
+      {"available_kb", meminfo.available},
+      {"buffers_kb", meminfo.buffers},
+      {"cached_kb", meminfo.cached},
+      {"slab_kb", meminfo.slab},
+      {"swap_total_kb", meminfo.swap_total},
+      {"swap_free_kb", meminfo.swap_free},
+      {"dirty_kb", meminfo.dirty}};
+  out += '{';
+  bool first{true};
+  for (const auto& [key, value] : fields) {
+    if (!first) {
+      out += ',';
+    }
+    first = false;
+    AppendKey(key, out);
+    AppendNumber(value, out);
+  }
+  out += '}';
+}
+
+// Append the pressure averages of each resource as a JSON object
+void AppendPressure(
+    const LinuxParser::Pressure (&pressure)[LinuxParser::kPressureResources],
+    string& out) {
+  static const char* const kResources[]{"cpu", "memory", "io"};
+  out += '{';
+  for (int i = 0; i < LinuxParser::kPressureResources; ++i) {
+    if (i > 0) {
+      out += ',';
+    }
+    AppendKey(kResources[i], out);
+    out += '{';
+    AppendKey("some", out);
+    out += '[';
+    for (int j = 0; j < 3; ++j) {
+      if (j > 0) {
+        out += ',';
+      }
+      AppendNumber(pressure[i].some[j], out);
+    }
+    out += "],";
+    AppendKey("full", out);
+    out += '[';
+    for (int j = 0; j < 3; ++j) {
+      if (j > 0) {
+        out += ',';
+      }
+      AppendNumber(pressure[i].full[j], out);
+    }
+    out += "]}";
+  }
+  out += '}';
+}
+}  // namespace
+
+// Write one JSON record per tick to stdout, count times (0 runs forever).
+// Ticks are scheduled at a fixed rate, so a slow collection shortens the
+// following sleep instead of shifting every later record.
+// With self_stats each record also carries the monitor's own cost, and with
+// groups the cgroup and user totals. Only the files behind the columns, and
+// those the totals need if asked for, are read.
+void NdjsonOutput::Run(System& system, int interval_ms, int count, int n,
+                       bool self_stats, const std::vector<Columns::Id>& columns,
+                       bool groups) {
+  string out;
+  out.reserve(kBufferSize);
+  Snapshot snapshot;
+  system.TopN(n);
+  system.Collect(Columns::Sources(columns) |
+                 (groups ? Columns::kGroupSources : 0));
+  const auto interval = std::chrono::milliseconds(interval_ms);
+  auto next = std::chrono::steady_clock::now();
+  for (int tick = 0; count == 0 || tick < count; ++tick) {
+    if (tick > 0) {
+      std::this_thread::sleep_until(next);
+    }
+    next += interval;
+    system.Refresh();
+    system.TakeSnapshot(snapshot);
+    out.clear();
+    AppendSnapshot(snapshot, out, columns, groups);
+    if (self_stats && Instrumentation::kEnabled) {
+      out.pop_back();
+      out += ',';
+      AppendKey("self", out);
+      AppendCost(snapshot.cost, out);
+      out += '}';
+    }
+    out += '\n';
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+  }
+}
+
+// Write one JSON record per sample of the watched processes, count times or
+// until they have all exited. Like Run(), samples keep a fixed rate.
+void NdjsonOutput::Watch(const std::vector<int>& pids, int interval_ms,
+                         int count) {
+  string out;
+  out.reserve(kBufferSize);
+  Watcher watcher(pids);
+  std::vector<Watcher::Sample> samples;
+  const auto interval = std::chrono::milliseconds(interval_ms);
+  auto next = std::chrono::steady_clock::now();
+  bool watching{true};
+  for (int tick = 0; watching && (count == 0 || tick < count); ++tick) {
+    if (tick > 0) {
+      std::this_thread::sleep_until(next);
+    }
+    next += interval;
+    watching = watcher.Read(samples);
+    out.clear();
+    out += '{';
+    AppendKey("time", out);
+    AppendNumber(std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count(),
+                 out);
+    out += ',';
+    AppendKey("processes", out);
+    out += '[';
+    bool first{true};
+    for (const auto& sample : samples) {
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      out += '{';
+      AppendKey("pid", out);
+      AppendNumber(sample.pid, out);
+      out += ',';
+      if (sample.exited) {
+        AppendKey("exited", out);
+        out += "true}";
+        continue;
+      }
+      AppendKey("state", out);
+      AppendString(string(1, sample.state), out);
+      out += ',';
+      AppendKey("cpu", out);
+      AppendNumber(sample.cpu, out);
+      out += ',';
+      AppendKey("ram_kb", out);
+      AppendNumber(sample.ram_kb, out);
+      out += ',';
+      AppendKey("majflt_rate", out);
+      AppendNumber(sample.major_fault_rate, out);
+      out += '}';
+    }
+    out += "]}\n";
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+  }
+}
+
+// Append the system metrics and the selected processes as one JSON object.
+// Processes carry their PID and the fields of the given columns; the cgroup
+// and user totals follow if groups is set.
+void NdjsonOutput::AppendSnapshot(const Snapshot& snapshot, string& out,
+                                  const std::vector<Columns::Id>& columns,
+                                  bool groups) {
+  out += '{';
+  AppendKey("time", out);
+  AppendNumber(snapshot.time_ms, out);
+  out += ',';
+  AppendKey("uptime", out);
+  AppendNumber(snapshot.uptime, out);
+  out += ',';
+  AppendKey("cpu", out);
+  AppendNumber(snapshot.cpu, out);
+  out += ',';
+  AppendKey("cores", out);
+  out += '[';
+  const auto& cores = snapshot.cores;
+  for (std::size_t i = 0; i < cores.size(); ++i) {
+    if (i > 0) {
+      out += ',';
+    }
+    AppendNumber(cores[i], out);
+  }
+  out += "],";
+  AppendKey("memory", out);
+  AppendNumber(snapshot.memory, out);
+  out += ',';
+  AppendKey("meminfo", out);
+  AppendMemInfo(snapshot.meminfo, out);
+  out += ',';
+  AppendKey("paging", out);
+  out += '{';
+  AppendKey("faults", out);
+  AppendNumber(snapshot.page_faults, out);
+  out += ',';
+  AppendKey("major_faults", out);
+  AppendNumber(snapshot.major_faults, out);
+  out += ',';
+  AppendKey("swap_ins", out);
+  AppendNumber(snapshot.swap_ins, out);
+  out += ',';
+  AppendKey("swap_outs", out);
+  AppendNumber(snapshot.swap_outs, out);
+  out += "},";
+  if (snapshot.has_pressure) {
+    AppendKey("pressure", out);
+    AppendPressure(snapshot.pressure, out);
+    out += ',';
+  }
+  AppendKey("load", out);
+  out += '[';
+  for (int i = 0; i < 3; ++i) {
+    if (i > 0) {
+      out += ',';
+    }
+    AppendNumber(snapshot.load_average[i], out);
+  }
+  out += "],";
+  AppendKey("total_processes", out);
+  AppendNumber(snapshot.total_processes, out);
+  out += ',';
+  AppendKey("running_processes", out);
+  AppendNumber(snapshot.running_processes, out);
+  out += ',';
+  AppendKey("processes", out);
+  out += '[';
+  bool first{true};
+  for (const auto& process : snapshot.processes) {
+    if (!first) {
+      out += ',';
+    }
+    first = false;
+    out += '{';
+    AppendKey("pid", out);
+    AppendNumber(process.pid, out);
+    for (const auto id : columns) {
+      switch (id) {
+        case Columns::Id::kPid:
+          continue;
+        case Columns::Id::kUser:
+          out += ',';
+          AppendKey("user", out);
+          AppendString(process.user, out);
+          break;
+        case Columns::Id::kCpu:
+          out += ',';
+          AppendKey("cpu", out);
+          AppendNumber(process.cpu, out);
+          break;
+        case Columns::Id::kRam:
+          out += ',';
+          AppendKey("ram_kb", out);
+          AppendNumber(process.ram_kb, out);
+          break;
+        case Columns::Id::kPss:
+          out += ',';
+          AppendKey("pss_kb", out);
+          AppendKnown(process.pss_kb, out);
+          break;
+        case Columns::Id::kSwap:
+          out += ',';
+          AppendKey("swap_kb", out);
+          AppendKnown(process.swap_kb, out);
+          break;
+        case Columns::Id::kRead:
+          out += ',';
+          AppendKey("read_bps", out);
+          AppendKnown(process.read_rate, out);
+          break;
+        case Columns::Id::kWrite:
+          out += ',';
+          AppendKey("write_bps", out);
+          AppendKnown(process.write_rate, out);
+          break;
+        case Columns::Id::kFaults:
+          out += ',';
+          AppendKey("majflt_rate", out);
+          AppendNumber(process.major_fault_rate, out);
+          break;
+        case Columns::Id::kTime:
+          out += ',';
+          AppendKey("uptime", out);
+          AppendNumber(process.uptime, out);
+          break;
+        case Columns::Id::kCommand:
+          out += ',';
+          AppendKey("command", out);
+          AppendString(process.command, out);
+          break;
+      }
+    }
+    out += '}';
+  }
+  out += ']';
+  if (groups) {
+    out += ',';
+    AppendKey("cgroups", out);
+    AppendGroups(snapshot.cgroups, out);
+    out += ',';
+    AppendKey("users", out);
+    AppendGroups(snapshot.users, out);
+  }
+  out += '}';
+}
+
+// Append rollups as an array of objects
+void NdjsonOutput::AppendGroups(const std::vector<GroupRow>& groups,
+                                string& out) {
+  out += '[';
+  bool first{true};
+  for (const auto& group : groups) {
+    if (!first) {
+      out += ',';
+    }
+    first = false;
+    out += '{';
+    AppendKey("name", out);
+    AppendString(group.name, out);
+    out += ',';
+    AppendKey("processes", out);
+    AppendNumber(group.processes, out);
+    out += ',';
+    AppendKey("cpu", out);
+    AppendNumber(group.cpu, out);
+    out += ',';
+    AppendKey("ram_kb", out);
+    AppendNumber(group.ram_kb, out);
+    out += '}';
+  }
+  out += ']';
+}
+
+// Append the phase times and /proc counters of a tick as a JSON object
+void NdjsonOutput::AppendCost(const Instrumentation::Tick& tick, string& out) {
+  out += '{';
+  for (int i = 0; i < Instrumentation::kPhaseCount; ++i) {
+    out += '"';
+    out += Instrumentation::PhaseName(static_cast<Instrumentation::Phase>(i));
+    out += "_ns\":";
+    AppendNumber(tick.phase_ns[i], out);
+    out += ',';
+  }
+  for (int i = 0; i < Instrumentation::kCounterCount; ++i) {
+    if (i > 0) {
+      out += ',';
+    }
+    AppendKey(
+        Instrumentation::CounterName(static_cast<Instrumentation::Counter>(i)),
+        out);
+    AppendNumber(tick.counters[i], out);
+  }
+  out += '}';
+}
+
+// Append value as a JSON string literal
+void NdjsonOutput::AppendString(const string& value, string& out) {
+  static const char kHex[] = "0123456789abcdef";
+  out += '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out += "\\u00";
+          out += kHex[(c >> 4) & 0xf];
+          out += kHex[c & 0xf];
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
@@ -0,0 +1,212 @@
+#include "open_metrics.h"
+
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "snapshot.h"
+
+using std::string;
+
+namespace {
+template <typename T>
+void AppendNumber(T value, string& out) {
+  char buffer[32];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr);
+}
+
+// The metadata lines that precede the samples of a metric family
+void AppendFamily(const char* name, const char* type, const char* help,
+                  string& out) {
+  out += "# TYPE ";
+  out += name;
+  out += ' ';
+  out += type;
+  out += "\n# HELP ";
+  out += name;
+  out += ' ';
+  out += help;
+  out += '\n';
+}
+
+// One sample; labels is empty or a list of name="value" pairs
+template <typename T>
+void AppendSample(const char* name, const string& labels, T value,
+                  string& out) {
+  out += name;
+  if (!labels.empty()) {
+    out += '{';
+    out += labels;
+    out += '}';
+  }
+  out += ' ';
+  AppendNumber(value, out);
+  out += '\n';
+}
+}  // namespace
+
+// Append name="value", escaping the value, after a comma if there are
+// labels before it
+void OpenMetrics::AppendLabel(const char* name, const string& value,
+                              string& out) {
+  if (!out.empty()) {
+    out += ',';
+  }
+  out += name;
+  out += "=\"";
+  for (const char c : value) {
+    switch (c) {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        out += c;
+    }
+  }
+  out += '"';
+}
+
+// Return the file name of the program of a command line, which unlike the
+// arguments does not vary between instances
+string OpenMetrics::Executable(const string& command) {
+  const auto end = command.find(' ');
+  const string program = command.substr(0, end);
+  const auto slash = program.rfind('/');
+  return slash == string::npos ? program : program.substr(slash + 1);
+}
+
+// Append the whole exposition, terminated by # EOF
+void OpenMetrics::AppendSnapshot(const Snapshot& snapshot, string& out) {
+  string labels;
+  AppendFamily("monitor_cpu_utilization", "gauge",
+               "Share of time all CPUs were busy since the previous refresh.",
+               out);
+  AppendSample("monitor_cpu_utilization", labels, snapshot.cpu, out);
+  AppendFamily("monitor_core_utilization", "gauge",
+               "Share of time each CPU was busy since the previous refresh.",
+               out);
+  for (std::size_t core = 0; core < snapshot.cores.size(); ++core) {
+    labels.clear();
+    AppendLabel("core", std::to_string(core), labels);
+    AppendSample("monitor_core_utilization", labels, snapshot.cores[core],
+                 out);
+  }
+
+  AppendFamily("monitor_memory_utilization", "gauge",
+               "Share of memory not available without swapping.", out);
+  AppendSample("monitor_memory_utilization", string(), snapshot.memory, out);
+  AppendFamily("monitor_memory_bytes", "gauge",
+               "Memory by kind, from /proc/meminfo.", out);
+  const LinuxParser::MemInfo& meminfo = snapshot.meminfo;
+  const std::pair<const char*, long> kinds[]{
+      {"total", meminfo.total},
+      {"free", meminfo.free},
+      {"available", meminfo.available},
+      {"buffers", meminfo.buffers},
+      {"cached", meminfo.cached},
+      {"slab", meminfo.slab},
+      {"swap_total", meminfo.swap_total},
+      {"swap_free", meminfo.swap_free},
+      {"dirty", meminfo.dirty}};
+  for (const auto& [kind, kilobytes] : kinds) {
+    labels.clear();
+    AppendLabel("kind", kind, labels);
+    AppendSample("monitor_memory_bytes", labels, kilobytes * 1024LL, out);
+  }
+
+  AppendFamily("monitor_load_average", "gauge",
+               "Run queue length averaged over 1, 5 and 15 minutes.", out);
+  static const char* const kPeriods[]{"1m", "5m", "15m"};
+  for (int i = 0; i < 3; ++i) {
+    labels.clear();
+    AppendLabel("period", kPeriods[i], labels);
+    AppendSample("monitor_load_average", labels, snapshot.load_average[i],
+                 out);
+  }
+  if (snapshot.has_pressure) {
+    AppendFamily("monitor_pressure_ratio", "gauge",
+                 "Share of time tasks stalled on a resource, from "
+                 "/proc/pressure.",
+                 out);
+    static const char* const kResources[]{"cpu", "memory", "io"};
+    static const char* const kWindows[]{"10s", "60s", "300s"};
+    for (int resource = 0; resource < LinuxParser::kPressureResources;
+         ++resource) {
+      const auto& pressure = snapshot.pressure[resource];
+      for (int window = 0; window < 3; ++window) {
+        for (const bool full : {false, true}) {
+          labels.clear();
+          AppendLabel("resource", kResources[resource], labels);
+          AppendLabel("kind", full ? "full" : "some", labels);
+          AppendLabel("window", kWindows[window], labels);
+          AppendSample(
+              "monitor_pressure_ratio", labels,
+              (full ? pressure.full[window] : pressure.some[window]) / 100,
+              out);
+        }
+      }
+    }
+  }
+  AppendFamily("monitor_processes", "gauge", "Processes on the system.",
+               out);
+  AppendSample("monitor_processes", string(), snapshot.live_processes, out);
+  AppendFamily("monitor_forks", "counter", "Processes created since boot.",
+               out);
+  AppendSample("monitor_forks_total", string(), snapshot.total_processes,
+               out);
+  AppendFamily("monitor_processes_running", "gauge",
+               "Processes running or runnable.", out);
+  AppendSample("monitor_processes_running", string(),
+               snapshot.running_processes, out);
+  AppendFamily("monitor_uptime_seconds", "gauge", "Time since boot.", out);
+  AppendSample("monitor_uptime_seconds", string(), snapshot.uptime, out);
+
+  // The listed processes summed by user and executable. A PID label would
+  // start a new series for every process that enters the list.
+  struct Program {
+    string labels;
+    float cpu{0};
+    long long ram_bytes{0};
+  };
+  std::vector<Program> programs;
+  for (const ProcessRow& process : snapshot.processes) {
+    labels.clear();
+    AppendLabel("user", process.user, labels);
+    AppendLabel("executable", Executable(process.command), labels);
+    auto it = std::find_if(
+        programs.begin(), programs.end(),
+        [&labels](const Program& program) { return program.labels == labels; });
+    if (it == programs.end()) {
+      it = programs.insert(programs.end(), Program{labels});
+    }
+    it->cpu += process.cpu;
+    it->ram_bytes += process.ram_kb * 1024LL;
+  }
+  AppendFamily("monitor_process_cpu_utilization", "gauge",
+               "Share of one CPU used by the top processes of a user and "
+               "executable since the previous refresh.",
+               out);
+  for (const Program& program : programs) {
+    AppendSample("monitor_process_cpu_utilization", program.labels,
+                 program.cpu, out);
+  }
+  AppendFamily("monitor_process_resident_memory_bytes", "gauge",
+               "Resident memory of the top processes of a user and "
+               "executable.",
+               out);
+  for (const Program& program : programs) {
+    AppendSample("monitor_process_resident_memory_bytes", program.labels,
+                 program.ram_bytes, out);
+  }
+  out += "# EOF\n";
+}
@@ -0,0 +1,297 @@
+#include "player.h"
+
+#include <curses.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+using std::size_t;
+using std::string;
+
+namespace {
+// Longest pause between two frames during playback, in recorded time, so
+// the gap between two recorded sessions is skipped
+constexpr long long kMaxGapMs{5000};
+
+// Playback speeds cycled through with 'f'
+constexpr int kSpeeds[]{1, 4, 16, 64};
+
+// Same order as System::Processes() for the same key
+bool Before(const ProcessRow& a, const ProcessRow& b, SortKey key) {
+  switch (key) {
+    case SortKey::kCpu:
+      if (a.cpu != b.cpu) {
+        return a.cpu > b.cpu;
+      }
+      break;
+    case SortKey::kRam:
+      if (a.ram_kb != b.ram_kb) {
+        return a.ram_kb > b.ram_kb;
+      }
+      break;
+    case SortKey::kUpTime:
+      if (a.uptime != b.uptime) {
+        return a.uptime > b.uptime;
+      }
+      break;
+    case SortKey::kUser:
+      if (a.user != b.user) {
+        return a.user < b.user;
+      }
+      break;
+    case SortKey::kPid:
+      break;
+  }
+  return a.pid < b.pid;
+}
+}  // namespace
+
+// Map the recording and show its first frame
+bool Player::Open(const string& path, string& error) {
+  if (!reader_.Open(path, error)) {
+    return false;
+  }
+  position_ = reader_.NextKeyframe(reader_.Begin());
+  next_ =
+      position_ < reader_.End() ? reader_.Decode(position_, snapshot_) : 0;
+  if (next_ == 0) {
+    error = path + " holds no complete frame";
+    return false;
+  }
+  sort_key_ = snapshot_.sort_key;
+  Sample(false);
+  Show();
+  clock_ = std::chrono::steady_clock::now();
+  return true;
+}
+
+// Keep window of history, in recorded time, from now on. The rings are sized
+// for the interval between the first frames, which the recorder keeps.
+void Player::KeepHistory(std::chrono::milliseconds window) {
+  const long long interval{
+      next_ < reader_.End()
+          ? reader_.Time(next_, snapshot_.time_ms) - snapshot_.time_ms
+          : 1000};
+  history_ = History(History::CapacityFor(window.count(), interval),
+                     window.count());
+  Sample(false);
+  Show();
+}
+
+// Advance by as many frames as the time since the last call allows
+bool Player::Update() {
+  const auto now = std::chrono::steady_clock::now();
+  if (!paused_) {
+    pending_ms_ +=
+        std::chrono::duration<double, std::milli>(now - clock_).count() *
+        speed_;
+    bool moved{false};
+    while (next_ < reader_.End()) {
+      const long long due =
+          std::min(kMaxGapMs, reader_.Time(next_, snapshot_.time_ms) -
+                                  snapshot_.time_ms);
+      if (due > pending_ms_ || !Forward()) {
+        break;
+      }
+      Sample(true);
+      pending_ms_ -= due;
+      moved = true;
+    }
+    if (moved) {
+      Show();
+    }
+    if (next_ >= reader_.End()) {
+      pending_ms_ = 0;
+    }
+  }
+  clock_ = now;
+  const bool changed{changed_};
+  changed_ = false;
+  return changed;
+}
+
+const Snapshot& Player::Current() const { return snapshot_; }
+
+// Re-sort the rows of the recording, which holds the processes that were
+// first in the order it was recorded with
+void Player::SortBy(SortKey key) {
+  sorted_ = true;
+  sort_key_ = key;
+  Show();
+}
+
+bool Player::HandleKey(int key) {
+  const long long now{snapshot_.time_ms};
+  switch (key) {
+    case ' ':
+      paused_ = !paused_;
+      pending_ms_ = 0;
+      changed_ = true;
+      return true;
+    case KEY_RIGHT:
+      paused_ = true;
+      StepForward();
+      return true;
+    case KEY_LEFT:
+      paused_ = true;
+      StepBackward();
+      return true;
+    case 'f': {
+      const auto* speed = std::find(std::begin(kSpeeds), std::end(kSpeeds),
+                                    speed_);
+      speed_ = speed + 1 < std::end(kSpeeds) ? speed[1] : kSpeeds[0];
+      changed_ = true;
+      return true;
+    }
+    case '<':
+      Seek(now - 60 * 1000);
+      return true;
+    case '>':
+      Seek(now + 60 * 1000);
+      return true;
+    case '{':
+      Seek(now - 600 * 1000);
+      return true;
+    case '}':
+      Seek(now + 600 * 1000);
+      return true;
+    case KEY_HOME:
+      Seek(LLONG_MIN);
+      return true;
+    case KEY_END:
+      Seek(LLONG_MAX);
+      return true;
+  }
+  return false;
+}
+
+// Time of the frame shown, the speed and whether playback is paused
+string Player::Status() const {
+  const std::time_t seconds = snapshot_.time_ms / 1000;
+  std::tm local{};
+  localtime_r(&seconds, &local);
+  char time[32];
+  std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &local);
+  char status[96];
+  std::snprintf(status, sizeof(status), "replay %s x%d%s", time, speed_,
+                next_ >= reader_.End() ? " end"
+                : paused_              ? " paused"
+                                       : "");
+  return status;
+}
+
+// Show the last frame at or before time_ms, or the first frame
+void Player::Seek(long long time_ms) {
+  const size_t keyframe = reader_.KeyframeAt(time_ms);
+  if (keyframe >= reader_.End()) {
+    return;
+  }
+  const size_t next = reader_.Decode(keyframe, snapshot_);
+  if (next == 0) {
+    return;
+  }
+  position_ = keyframe;
+  next_ = next;
+  while (next_ < reader_.End() &&
+         reader_.Time(next_, snapshot_.time_ms) <= time_ms && Forward()) {
+  }
+  pending_ms_ = 0;
+  Sample(false);
+  Show();
+}
+
+bool Player::StepForward() {
+  if (!Forward()) {
+    return false;
+  }
+  Sample(true);
+  Show();
+  return true;
+}
+
+// Decode again from the keyframe before the frame shown up to the frame
+// before it
+bool Player::StepBackward() {
+  const size_t keyframe = reader_.PreviousKeyframe(position_);
+  if (keyframe >= reader_.End()) {
+    return false;
+  }
+  size_t position = keyframe;
+  size_t next;
+  while ((next = reader_.Decode(position, snapshot_)) != 0 &&
+         next != position_) {
+    position = next;
+  }
+  if (next == 0) {
+    return false;
+  }
+  next_ = position_;
+  position_ = position;
+  Sample(false);
+  Show();
+  return true;
+}
+
+// Decode the next frame without showing it
+bool Player::Forward() {
+  if (next_ >= reader_.End()) {
+    return false;
+  }
+  const size_t next = reader_.Decode(next_, snapshot_);
+  if (next == 0) {
+    next_ = reader_.End();
+    return false;
+  }
+  position_ = next_;
+  next_ = next;
+  return true;
+}
+
+// Add the frame decoded last to the history. The history carries on from
+// the previous frame when playback is continuous and starts over after a
+// jump.
+void Player::Sample(bool continuous) {
+  if (!continuous) {
+    history_ = History(history_.Capacity(), history_.Window());
+  }
+  history_.Begin(snapshot_.time_ms, snapshot_.cpu, snapshot_.memory,
+                 snapshot_.cores);
+  for (const auto& row : snapshot_.processes) {
+    // Start time in seconds since boot, constant for the process's lifetime
+    const int slot = history_.Track(row.pid, snapshot_.uptime - row.uptime);
+    if (slot >= 0) {
+      history_.Record(slot, row.cpu, row.ram_kb);
+    }
+  }
+  history_.End();
+}
+
+// Sort the rows of the current frame and fill in their history
+void Player::Show() {
+  if (sorted_) {
+    snapshot_.sort_key = sort_key_;
+  }
+  auto& rows = snapshot_.processes;
+  const SortKey key{snapshot_.sort_key};
+  std::sort(rows.begin(), rows.end(),
+            [key](const ProcessRow& a, const ProcessRow& b) {
+              return Before(a, b, key);
+            });
+
+  snapshot_.history_length = history_.Length();
+  history_.Cpu(snapshot_.cpu_history);
+  history_.Memory(snapshot_.memory_history);
+  snapshot_.core_history.resize(history_.Cores());
+  for (size_t core = 0; core < history_.Cores(); ++core) {
+    history_.Core(core, snapshot_.core_history[core]);
+  }
+  for (auto& row : rows) {
+    history_.Process(row.pid, row.cpu_history, row.rss_history);
+  }
+  snapshot_.sequence = ++sequence_;
+  changed_ = true;
+}
@@ -0,0 +1,72 @@
+#include "proc_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <utility>
+
+#include "instrumentation.h"
+
+// Initial buffer size; grown on demand for large files such as /proc/stat on
+// hosts with many CPUs
+constexpr std::size_t kInitialBufferSize{4096};
+
+ProcFile::ProcFile(std::string path)
+    : path_(std::move(path)), buffer_(kInitialBufferSize) {}
+
+ProcFile::~ProcFile() { Close(); }
+
+// Read the current contents of the file. contents stays valid until the
+// next call.
+bool ProcFile::Read(std::string_view& contents) {
+  long size = (fd_ >= 0 || Open()) ? ReadAll() : -1;
+  if (size < 0) {
+    // The descriptor may have gone stale; reopen once and retry
+    Close();
+    size = Open() ? ReadAll() : -1;
+  }
+  if (size < 0) {
+    return false;
+  }
+  contents = std::string_view(buffer_.data(), size);
+  return true;
+}
+
+bool ProcFile::Open() {
+  fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  MONITOR_COUNT(kOpens, 1);
+  return fd_ >= 0;
+}
+
+void ProcFile::Close() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+// pread the file from offset 0 into buffer_, doubling the buffer until the
+// whole file fits. Returns the size read or -1 on error.
+long ProcFile::ReadAll() {
+  while (true) {
+    std::size_t total = 0;
+    while (total < buffer_.size()) {
+      const ssize_t n =
+          pread(fd_, buffer_.data() + total, buffer_.size() - total, total);
+      MONITOR_COUNT(kReads, 1);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        return -1;
+      }
+      if (n == 0) {
+        MONITOR_COUNT(kBytesRead, total);
+        return static_cast<long>(total);
+      }
+      total += static_cast<std::size_t>(n);
+    }
+    buffer_.resize(buffer_.size() * 2);
+  }
+}
@@ -5,6 +5,7 @@
 #include <cctype>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "linux_parser.h"
@@ -13,8 +14,36 @@ using std::string;
 using std::to_string;
 using std::vector;
 
+namespace {
+// Size of a memory page in kB, the unit of the rss field of stat
+long PageKilobytes() {
+  static const long kilobytes{sysconf(_SC_PAGESIZE) / 1024};
+  return kilobytes;
+}
+}  // namespace
+
 // Add constructor for Process
-Process::Process(int pid) : pid_(pid) {}
+Process::Process(int pid) : pid_(pid) {
+  LinuxParser::ProcStat stat;
+  if (LinuxParser::ReadProcStat(pid, stat)) {
+    *this = Process(stat);
+  }
+  LinuxParser::ProcStatus status;
+  if (LinuxParser::ReadProcStatus(pid, status)) {
+    Update(status);
+  }
+}
+
+// Build a process from an already parsed /proc/[pid]/stat record
+Process::Process(const LinuxParser::ProcStat& stat)
+    : pid_(stat.pid),
+      ppid_(stat.ppid),
+      state_(stat.state),
+      active_jiffies_(stat.utime + stat.stime),
+      start_time_(stat.starttime),
+      ram_(stat.rss * PageKilobytes()),
+      comm_(stat.comm),
+      majflt_(stat.majflt) {}
 
 //  Return this process's ID
 int Process::Pid() const { return pid_; }
@@ -22,23 +51,157 @@ int Process::Pid() const { return pid_; }
 //  Return this process's CPU utilization
 float Process::CpuUtilization() const { return cpu_; }
 
+// Update the CPU utilization from a new sample. system_jiffles is the
+// system jiffy clock of a single CPU, so the result is a fraction of one core.
+// The first sample has no previous one and falls back to the lifetime average.
 void Process::CpuUtilization(long active_jiffles, long system_jiffles) {
-  cpu_ = (static_cast<float>(active_jiffles)/ LinuxParser::ClockTicksPerSecond())/UpTime();
+  long duration_active{active_jiffles - cached_active_jiffles_};
+  long duration{system_jiffles - cached_system_jiffles_};
+  if (cached_system_jiffles_ == 0) {
+    duration = system_jiffles - start_time_;
+  }
+  if (duration > 0) {
+    cpu_ = static_cast<float>(duration_active) / duration;
+  }
   cached_active_jiffles_ = active_jiffles;
   cached_system_jiffles_ = system_jiffles;
 }
 
+// Refresh a surviving process in place from its latest stat record
+void Process::Update(const LinuxParser::ProcStat& stat, long system_jiffles) {
+  // The system jiffies of one CPU advance at the clock tick rate
+  const long elapsed{system_jiffles - cached_system_jiffles_};
+  if (cached_system_jiffles_ != 0 && elapsed > 0) {
+    majflt_rate_ = static_cast<float>(stat.majflt - majflt_) *
+                   LinuxParser::ClockTicksPerSecond() / elapsed;
+  }
+  majflt_ = stat.majflt;
+  ppid_ = stat.ppid;
+  state_ = stat.state;
+  ram_ = stat.rss * PageKilobytes();
+  if (comm_ != stat.comm) {
+    comm_ = stat.comm;
+  }
+  active_jiffies_ = stat.utime + stat.stime;
+  CpuUtilization(active_jiffies_, system_jiffles);
+}
+
+//  Return the jiffies this process has spent on the CPU
+long Process::ActiveJiffies() const { return active_jiffies_; }
+
+// Refresh the owner of a process from its status record. Resident memory
+// comes from stat, which is read every refresh anyway.
+void Process::Update(const LinuxParser::ProcStatus& status) {
+  uid_ = status.uid;
+}
+
+// Refresh the I/O counters, and their rates once there is a previous sample
+void Process::Update(const LinuxParser::ProcIo& io,
+                     std::chrono::steady_clock::time_point now) {
+  if (io_time_ != std::chrono::steady_clock::time_point{}) {
+    const float seconds{std::chrono::duration<float>(now - io_time_).count()};
+    if (seconds > 0) {
+      read_rate_ = (io.read_bytes - read_bytes_) / seconds;
+      write_rate_ = (io.write_bytes - write_bytes_) / seconds;
+    }
+  }
+  read_bytes_ = io.read_bytes;
+  write_bytes_ = io.write_bytes;
+  io_time_ = now;
+}
+
+// Refresh the proportional and swapped memory of a process
+void Process::Update(const LinuxParser::ProcMemory& memory) {
+  pss_ = memory.pss;
+  swap_ = memory.swap;
+}
+
+//  Return the proportional set size in kB, shared pages split between the
+//  processes that map them
+long Process::PssKilobytes() const { return pss_; }
+
+//  Return the swapped out memory in kB
+long Process::SwapKilobytes() const { return swap_; }
+
+//  Return the bytes read from storage per second
+float Process::ReadRate() const { return read_rate_; }
+
+//  Return the bytes written to storage per second
+float Process::WriteRate() const { return write_rate_; }
+
+//  Return the major page faults per second
+float Process::MajorFaultRate() const { return majflt_rate_; }
+
+//  Return the start time of this process in jiffies after boot
+long Process::StartTime() const { return start_time_; }
+
+//  Return the name of the executable, as truncated by the kernel
+const string& Process::Comm() const { return comm_; }
+
+//  Return the PID of the parent process
+int Process::ParentPid() const { return ppid_; }
+
+//  Return the scheduling state, R, S, D, Z, ... as of the last refresh
+char Process::State() const { return state_; }
+
+// Fetch the command line unless it is already known
+void Process::ResolveCommand() {
+  if (!command_known_) {
+    command_ = LinuxParser::Command(pid_);
+    command_known_ = true;
+  }
+}
+
+// Look the user name up unless it is already known for the current owner
+void Process::ResolveUser() {
+  if (user_.empty() || user_uid_ != uid_) {
+    user_ = LinuxParser::UserName(uid_);
+    user_uid_ = uid_;
+  }
+}
+
+// The process replaced its program, so its command line has to be read again
+void Process::Exec() {
+  command_known_ = false;
+  command_.clear();
+}
+
+// Keep a command line that was read on the collector's behalf
+void Process::Command(string command) {
+  command_ = std::move(command);
+  command_known_ = true;
+}
+
+//  Return the command line if it has been read since the last exec
+const string* Process::KnownCommand() const {
+  return command_known_ ? &command_ : nullptr;
+}
+
 //  Return the command that generated this process
-string Process::Command() const { return LinuxParser::Command(Pid()); }
+string Process::Command() const {
+  return command_known_ ? command_ : LinuxParser::Command(Pid());
+}
 
 //  Return this process's memory utilization
-string Process::Ram() const { return LinuxParser::Ram(Pid()); }
+string Process::Ram() const { return to_string(ram_ / 1024); }
+
+//  Return this process's resident memory in kB
+long Process::RamKilobytes() const { return ram_; }
+
+//  Return the ID of the user that owns this process
+int Process::Uid() const { return uid_; }
 
 //  Return the user (name) that generated this process
-string Process::User() const { return LinuxParser::User(Pid()); }
+string Process::User() const {
+  return !user_.empty() && user_uid_ == uid_ ? user_
+                                             : LinuxParser::UserName(uid_);
+}
 
 //  Return the age of this process (in seconds)
-long int Process::UpTime() const { return LinuxParser::UpTime(Pid()); }
+long int Process::UpTime() const {
+  return LinuxParser::UpTime() -
+         start_time_ / LinuxParser::ClockTicksPerSecond();
+}
 
 //  Overload the "greater than" comparison operator for Process objects
 bool Process::operator>(const Process& a) const {
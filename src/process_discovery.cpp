@@ -0,0 +1,200 @@
+#include "process_discovery.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "instrumentation.h"
+#include "linux_parser.h"
+
+using std::vector;
+
+namespace {
+// How often the netlink backend checks its PID set against the directory
+constexpr std::chrono::seconds kReconcileInterval{10};
+
+// How long to wait for the kernel to acknowledge the subscription
+constexpr int kAckTimeoutMs{200};
+
+// Receive buffer asked for, so bursts of forks do not overrun the socket
+constexpr int kReceiveBufferSize{1 << 20};
+
+// Send a listen or ignore request to the proc connector
+bool Control(int socket, proc_cn_mcast_op op) {
+  alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(op))]{};
+  auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+  header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(op));
+  header->nlmsg_type = NLMSG_DONE;
+  header->nlmsg_pid = getpid();
+  auto* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->len = sizeof(op);
+  std::memcpy(message->data, &op, sizeof(op));
+  return send(socket, buffer, header->nlmsg_len, 0) ==
+         static_cast<ssize_t>(header->nlmsg_len);
+}
+
+// Whether the process tgid has exited, now that its leader has. A leader
+// that called pthread_exit stays a zombie while the other threads run; the
+// exits of those are not followed, and the reconcile drops the PID later.
+bool Exited(int tgid) {
+  LinuxParser::ProcStat stat;
+  return !LinuxParser::ReadProcStat(tgid, stat) ||
+         ((stat.state == 'Z' || stat.state == 'X') && stat.num_threads <= 1);
+}
+}  // namespace
+
+// Use the netlink backend if asked to and if it is available
+ProcessDiscovery::ProcessDiscovery(Backend backend) {
+  if (backend == Backend::kNetlink &&
+      LinuxParser::ProcDirectory() == LinuxParser::kProcDirectory) {
+    Subscribe();
+  }
+}
+
+ProcessDiscovery::~ProcessDiscovery() { Close(); }
+
+// Return the backend in use, which is the scan if subscribing failed
+ProcessDiscovery::Backend ProcessDiscovery::Active() const {
+  return socket_ >= 0 ? Backend::kNetlink : Backend::kScan;
+}
+
+// Return the PIDs of the live processes, in no particular order
+const vector<int>& ProcessDiscovery::Pids() {
+  execs_.clear();
+  if (socket_ < 0) {
+    LinuxParser::Pids(pids_);
+    return pids_;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  if (reconcile_ || now - reconciled_ >= kReconcileInterval) {
+    // Events already queued are applied on top of the scan. They are in
+    // order, so a PID that exited after the scan is still removed.
+    LinuxParser::Pids(pids_);
+    live_.clear();
+    live_.insert(pids_.begin(), pids_.end());
+    reconciled_ = now;
+    reconcile_ = false;
+  }
+  {
+    MONITOR_TIME_PHASE(kScan);
+    reconcile_ = !Drain();
+  }
+  pids_.assign(live_.begin(), live_.end());
+  return pids_;
+}
+
+// Return the processes that called exec during the last Pids(), as far as
+// the backend knows; the scan backend never does
+const vector<int>& ProcessDiscovery::Execs() const { return execs_; }
+
+// Bind to the proc connector group and wait for the kernel to accept the
+// subscription
+bool ProcessDiscovery::Subscribe() {
+  socket_ = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                   NETLINK_CONNECTOR);
+  if (socket_ < 0) {
+    return false;
+  }
+  setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &kReceiveBufferSize,
+             sizeof(kReceiveBufferSize));
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+          0 ||
+      !Control(socket_, PROC_CN_MCAST_LISTEN)) {
+    Close();
+    return false;
+  }
+
+  // The kernel answers with an event carrying the error of the request
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(kAckTimeoutMs);
+  alignas(nlmsghdr) char buffer[4096];
+  while (std::chrono::steady_clock::now() < deadline) {
+    pollfd descriptor{socket_, POLLIN, 0};
+    if (poll(&descriptor, 1, kAckTimeoutMs) <= 0) {
+      break;
+    }
+    const ssize_t size = recv(socket_, buffer, sizeof(buffer), 0);
+    if (size <= 0) {
+      continue;
+    }
+    int length = size;
+    for (auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+         NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+      const auto* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+      const auto* event = reinterpret_cast<const proc_event*>(message->data);
+      if (event->what == proc_event::PROC_EVENT_NONE) {
+        if (event->event_data.ack.err != 0) {
+          Close();
+          return false;
+        }
+        return true;
+      }
+    }
+  }
+  Close();
+  return false;
+}
+
+// Apply the queued events to the PID set. Returns false if events were lost
+// and the set has to be rebuilt from a scan.
+bool ProcessDiscovery::Drain() {
+  alignas(nlmsghdr) char buffer[16384];
+  while (true) {
+    const ssize_t size = recv(socket_, buffer, sizeof(buffer), 0);
+    if (size < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    int length = size;
+    for (auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+         NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+      const auto* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+      const auto* event = reinterpret_cast<const proc_event*>(message->data);
+      MONITOR_COUNT(kProcEvents, 1);
+      switch (event->what) {
+        case proc_event::PROC_EVENT_FORK: {
+          // Threads are announced as forks too; only processes are kept
+          const auto& fork = event->event_data.fork;
+          if (fork.child_pid == fork.child_tgid) {
+            live_.insert(fork.child_tgid);
+          }
+          break;
+        }
+        case proc_event::PROC_EVENT_EXEC:
+          live_.insert(event->event_data.exec.process_tgid);
+          execs_.push_back(event->event_data.exec.process_tgid);
+          break;
+        case proc_event::PROC_EVENT_EXIT: {
+          const auto& exit = event->event_data.exit;
+          if (exit.process_pid == exit.process_tgid &&
+              Exited(exit.process_tgid)) {
+            live_.erase(exit.process_tgid);
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+}
+
+void ProcessDiscovery::Close() {
+  if (socket_ >= 0) {
+    Control(socket_, PROC_CN_MCAST_IGNORE);
+    close(socket_);
+    socket_ = -1;
+  }
+}
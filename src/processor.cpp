@@ -2,16 +2,34 @@
 
 #include "linux_parser.h"
 
-// TReturn the aggregate CPU utilization
-float Processor::Utilization() {
-  float utilization{0};
-  long active_jiffles = LinuxParser::ActiveJiffies();
-  long idle_jiffles = LinuxParser::IdleJiffies();
-  long duration_active{active_jiffles - cached_active_jiffles_};
-  long duration_idle{idle_jiffles - cached_idle_jiffles_};
+// Return the aggregate CPU utilization
+float Processor::Utilization() const { return total_.utilization; }
+
+// Return the utilization of every CPU, indexed by CPU number
+const std::vector<float>& Processor::CoreUtilization() const {
+  return core_utilization_;
+}
+
+// Update the aggregate and per-core utilization from a /proc/stat snapshot
+void Processor::Update(const LinuxParser::StatSnapshot& snapshot) {
+  total_.Update(snapshot.cpu);
+  cores_.resize(snapshot.cores.size());
+  core_utilization_.resize(snapshot.cores.size());
+  for (std::size_t i = 0; i < cores_.size(); ++i) {
+    cores_[i].Update(snapshot.cores[i]);
+    core_utilization_[i] = cores_[i].utilization;
+  }
+}
+
+void Processor::Counter::Update(const LinuxParser::CpuTimes& times) {
+  long active_jiffles = times.Active();
+  long idle_jiffles = times.Idle();
+  long duration_active{active_jiffles - cached_active_jiffles};
+  long duration_idle{idle_jiffles - cached_idle_jiffles};
   long duration{duration_active + duration_idle};
-  utilization = static_cast<float>(duration_active) / duration;
-  cached_active_jiffles_ = active_jiffles;
-  cached_idle_jiffles_ = idle_jiffles;
-  return utilization;
-}
\ No newline at end of file
+  if (duration > 0) {
+    utilization = static_cast<float>(duration_active) / duration;
+  }
+  cached_active_jiffles = active_jiffles;
+  cached_idle_jiffles = idle_jiffles;
+}
@@ -0,0 +1,473 @@
+#include "recording.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "columns.h"
+#include "history.h"
+#include "snapshot.h"
+#include "system.h"
+
+using std::size_t;
+using std::string;
+using std::uint64_t;
+
+namespace {
+// Size of the kind byte and the payload size in front of every payload
+constexpr size_t kFrameHeaderSize{5};
+
+// Values stored as integers: utilization in History fixed point, load
+// averages in hundredths
+long long Fixed(float utilization) { return History::Fixed(utilization); }
+float Utilization(long long fixed) {
+  return static_cast<float>(fixed) / History::kScale;
+}
+long long Hundredths(float value) { return std::llround(value * 100); }
+
+void PutVarint(uint64_t value, string& out) {
+  while (value >= 0x80) {
+    out += static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+// Signed values are zigzag encoded so small differences stay small
+void PutDelta(long long value, long long previous, string& out) {
+  const long long delta = value - previous;
+  PutVarint((static_cast<uint64_t>(delta) << 1) ^
+                static_cast<uint64_t>(delta >> 63),
+            out);
+}
+
+void PutString(const string& value, string& out) {
+  PutVarint(value.size(), out);
+  out += value;
+}
+
+// Bounds-checked reading of a payload. After any read past the end, ok is
+// false and every further read returns 0.
+struct Cursor {
+  const char* p;
+  const char* end;
+  bool ok{true};
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (p >= end) {
+        break;
+      }
+      const auto byte = static_cast<unsigned char>(*p++);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    ok = false;
+    return 0;
+  }
+
+  long long Delta(long long previous) {
+    const uint64_t value = Varint();
+    return previous + static_cast<long long>((value >> 1) ^ -(value & 1));
+  }
+
+  void String(string& value) {
+    const uint64_t size = Varint();
+    if (!ok || size > static_cast<uint64_t>(end - p)) {
+      ok = false;
+      return;
+    }
+    value.assign(p, size);
+    p += size;
+  }
+};
+
+std::uint32_t LoadSize(const char* p) {
+  std::uint32_t size = 0;
+  for (int i = 3; i >= 0; --i) {
+    size = size << 8 | static_cast<unsigned char>(p[i]);
+  }
+  return size;
+}
+}  // namespace
+
+Recording::Writer::~Writer() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+  }
+}
+
+// Open path for appending, writing the file header if it is new. A session
+// appended to an existing recording starts with a keyframe.
+bool Recording::Writer::Open(const string& path, string& error) {
+  file_ = std::fopen(path.c_str(), "ab");
+  if (file_ == nullptr) {
+    error = "cannot open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  if (std::ftell(file_) == 0 &&
+      std::fwrite(kFileHeader, sizeof(kFileHeader), 1, file_) != 1) {
+    error = "cannot write " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  since_keyframe_ = 0;
+  return true;
+}
+
+// Append one snapshot as a frame and flush it, so a crash loses at most the
+// frame being written
+bool Recording::Writer::Append(const Snapshot& snapshot) {
+  const bool key = since_keyframe_ == 0;
+  since_keyframe_ = (since_keyframe_ + 1) % kKeyframeInterval;
+  // A keyframe is encoded as differences to zero
+  static const Snapshot kEmpty;
+  const Snapshot& previous = key ? kEmpty : previous_;
+
+  frame_.clear();
+  if (key) {
+    frame_.append(kSync, sizeof(kSync));
+  }
+  frame_ += key ? 'K' : 'D';
+  const size_t size_offset = frame_.size();
+  frame_.append(4, '\0');
+
+  PutDelta(snapshot.time_ms, previous.time_ms, frame_);
+  PutDelta(snapshot.uptime, previous.uptime, frame_);
+  if (key) {
+    PutString(snapshot.operating_system, frame_);
+    PutString(snapshot.kernel, frame_);
+  }
+  PutDelta(Fixed(snapshot.cpu), Fixed(previous.cpu), frame_);
+  PutVarint(snapshot.cores.size(), frame_);
+  for (size_t i = 0; i < snapshot.cores.size(); ++i) {
+    const float before = i < previous.cores.size() ? previous.cores[i] : 0;
+    PutDelta(Fixed(snapshot.cores[i]), Fixed(before), frame_);
+  }
+  PutDelta(Fixed(snapshot.memory), Fixed(previous.memory), frame_);
+  for (int i = 0; i < 3; ++i) {
+    PutDelta(Hundredths(snapshot.load_average[i]),
+             Hundredths(previous.load_average[i]), frame_);
+  }
+  PutDelta(snapshot.total_processes, previous.total_processes, frame_);
+  PutDelta(snapshot.running_processes, previous.running_processes, frame_);
+  PutVarint(static_cast<uint64_t>(snapshot.sort_key), frame_);
+
+  // Rows of a process already in the previous frame only carry differences
+  PutVarint(snapshot.processes.size(), frame_);
+  for (const ProcessRow& row : snapshot.processes) {
+    PutVarint(row.pid, frame_);
+    const ProcessRow* before = nullptr;
+    if (!key) {
+      const auto it = previous_rows_.find(row.pid);
+      if (it != previous_rows_.end()) {
+        before = &previous.processes[it->second];
+        if (before->uid != row.uid || before->user != row.user ||
+            before->command != row.command) {
+          before = nullptr;
+        }
+      }
+    }
+    static const ProcessRow kNew;
+    frame_ += before != nullptr ? '\0' : '\1';
+    if (before == nullptr) {
+      before = &kNew;
+      PutDelta(row.uid, 0, frame_);
+      PutString(row.user, frame_);
+      PutString(row.command, frame_);
+    }
+    PutDelta(Fixed(row.cpu), Fixed(before->cpu), frame_);
+    PutDelta(row.ram_kb, before->ram_kb, frame_);
+    PutDelta(row.uptime, before->uptime, frame_);
+  }
+
+  const auto size =
+      static_cast<std::uint32_t>(frame_.size() - size_offset - 4);
+  for (int i = 0; i < 4; ++i) {
+    frame_[size_offset + i] = static_cast<char>(size >> (8 * i));
+  }
+  if (std::fwrite(frame_.data(), 1, frame_.size(), file_) != frame_.size() ||
+      std::fflush(file_) != 0) {
+    return false;
+  }
+
+  // Remember what the next frame is encoded against, without the history
+  previous_.time_ms = snapshot.time_ms;
+  previous_.uptime = snapshot.uptime;
+  previous_.cpu = snapshot.cpu;
+  previous_.cores = snapshot.cores;
+  previous_.memory = snapshot.memory;
+  std::copy(snapshot.load_average, snapshot.load_average + 3,
+            previous_.load_average);
+  previous_.total_processes = snapshot.total_processes;
+  previous_.running_processes = snapshot.running_processes;
+  previous_.processes.resize(snapshot.processes.size());
+  previous_rows_.clear();
+  for (size_t i = 0; i < snapshot.processes.size(); ++i) {
+    const ProcessRow& row = snapshot.processes[i];
+    ProcessRow& copy = previous_.processes[i];
+    copy.pid = row.pid;
+    copy.uid = row.uid;
+    copy.user = row.user;
+    copy.command = row.command;
+    copy.cpu = row.cpu;
+    copy.ram_kb = row.ram_kb;
+    copy.uptime = row.uptime;
+    previous_rows_[row.pid] = i;
+  }
+  return true;
+}
+
+Recording::Reader::~Reader() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+// Map the recording and find where its last complete frame ends. Only the
+// header and the frames after the last keyframe are read.
+bool Recording::Reader::Open(const string& path, string& error) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = "cannot open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      status.st_size < static_cast<off_t>(sizeof(kFileHeader))) {
+    close(fd);
+    error = path + " is not a recording";
+    return false;
+  }
+  size_ = status.st_size;
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    error = "cannot map " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  data_ = static_cast<const char*>(data);
+  if (std::memcmp(data_, kFileHeader, sizeof(kFileHeader)) != 0) {
+    error = path + " is not a recording";
+    return false;
+  }
+
+  end_ = size_;
+  size_t position = PreviousKeyframe(size_);
+  if (position == size_) {
+    end_ = Begin();
+    return true;
+  }
+  // Walk to the end of the last frame that was written completely
+  Snapshot scratch;
+  size_t next;
+  while ((next = Decode(position, scratch)) != 0) {
+    position = next;
+  }
+  end_ = position;
+  return true;
+}
+
+// Position of the first frame
+size_t Recording::Reader::Begin() const { return sizeof(kFileHeader); }
+
+// Position just past the last complete frame
+size_t Recording::Reader::End() const { return end_; }
+
+bool Recording::Reader::IsKeyframe(size_t position) const {
+  return position + sizeof(kSync) + kFrameHeaderSize <= size_ &&
+         std::memcmp(data_ + position, kSync, sizeof(kSync)) == 0 &&
+         data_[position + sizeof(kSync)] == 'K';
+}
+
+// First keyframe at or after position, or End() if there is none
+size_t Recording::Reader::NextKeyframe(size_t position) const {
+  while (position < end_) {
+    const void* found = memmem(data_ + position, end_ - position, kSync,
+                               sizeof(kSync));
+    if (found == nullptr) {
+      break;
+    }
+    position = static_cast<const char*>(found) - data_;
+    if (IsKeyframe(position)) {
+      return position;
+    }
+    ++position;
+  }
+  return end_;
+}
+
+// Last keyframe before position, or End() if there is none
+size_t Recording::Reader::PreviousKeyframe(size_t position) const {
+  while (position > Begin()) {
+    --position;
+    if (data_[position] == kSync[0] && IsKeyframe(position)) {
+      return position;
+    }
+  }
+  return end_;
+}
+
+// Time of the frame at position, given the time of the frame before it
+long long Recording::Reader::Time(size_t position,
+                                  long long previous_ms) const {
+  const bool key = IsKeyframe(position);
+  const size_t header = position + (key ? sizeof(kSync) : 0);
+  if (header + kFrameHeaderSize > size_) {
+    return previous_ms;
+  }
+  Cursor cursor{data_ + header + kFrameHeaderSize, data_ + size_};
+  return cursor.Delta(key ? 0 : previous_ms);
+}
+
+// The last keyframe at or before time_ms, or the first keyframe if the
+// recording starts later. Keyframes are found by bisecting the file.
+size_t Recording::Reader::KeyframeAt(long long time_ms) const {
+  size_t best = NextKeyframe(Begin());
+  if (best == end_ || Time(best, 0) > time_ms) {
+    return best;
+  }
+  size_t low = best + 1;
+  size_t high = end_;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    const size_t keyframe = NextKeyframe(middle);
+    if (keyframe < end_ && Time(keyframe, 0) <= time_ms) {
+      best = keyframe;
+      low = keyframe + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return best;
+}
+
+// Decode the frame at position into snapshot, which must hold the previous
+// frame unless this one is a keyframe. Returns the position of the next
+// frame, or 0 if there is no complete, well-formed frame at position.
+size_t Recording::Reader::Decode(size_t position, Snapshot& snapshot) const {
+  const bool key = IsKeyframe(position);
+  const size_t header = position + (key ? sizeof(kSync) : 0);
+  if (header + kFrameHeaderSize > size_ ||
+      data_[header] != (key ? 'K' : 'D')) {
+    return 0;
+  }
+  const size_t next = header + kFrameHeaderSize + LoadSize(data_ + header + 1);
+  if (next > size_) {
+    return 0;
+  }
+  Cursor in{data_ + header + kFrameHeaderSize, data_ + next};
+  static const Snapshot kEmpty;
+  const Snapshot& previous = key ? kEmpty : snapshot;
+
+  Snapshot decoded;
+  decoded.time_ms = in.Delta(previous.time_ms);
+  decoded.uptime = in.Delta(previous.uptime);
+  if (key) {
+    in.String(decoded.operating_system);
+    in.String(decoded.kernel);
+  } else {
+    decoded.operating_system = snapshot.operating_system;
+    decoded.kernel = snapshot.kernel;
+  }
+  decoded.cpu = Utilization(in.Delta(Fixed(previous.cpu)));
+  const uint64_t cores = in.Varint();
+  if (cores > static_cast<uint64_t>(in.end - in.p)) {
+    return 0;
+  }
+  decoded.cores.resize(cores);
+  for (size_t i = 0; i < cores; ++i) {
+    const float before = i < previous.cores.size() ? previous.cores[i] : 0;
+    decoded.cores[i] = Utilization(in.Delta(Fixed(before)));
+  }
+  decoded.memory = Utilization(in.Delta(Fixed(previous.memory)));
+  for (int i = 0; i < 3; ++i) {
+    decoded.load_average[i] =
+        in.Delta(Hundredths(previous.load_average[i])) / 100.0f;
+  }
+  decoded.total_processes = in.Delta(previous.total_processes);
+  decoded.running_processes = in.Delta(previous.running_processes);
+  decoded.sort_key = static_cast<SortKey>(in.Varint() % 5);
+
+  std::unordered_map<int, const ProcessRow*> rows;
+  for (const ProcessRow& row : previous.processes) {
+    rows[row.pid] = &row;
+  }
+  const uint64_t count = in.Varint();
+  if (count > static_cast<uint64_t>(in.end - in.p)) {
+    return 0;
+  }
+  decoded.processes.resize(count);
+  for (ProcessRow& row : decoded.processes) {
+    row.pid = in.Varint();
+    const bool full = in.p < in.end && *in.p++ != '\0';
+    static const ProcessRow kNew;
+    const ProcessRow* before = &kNew;
+    if (full) {
+      row.uid = in.Delta(0);
+      in.String(row.user);
+      in.String(row.command);
+    } else {
+      const auto it = rows.find(row.pid);
+      if (it == rows.end()) {
+        return 0;
+      }
+      before = it->second;
+      row.uid = before->uid;
+      row.user = before->user;
+      row.command = before->command;
+    }
+    row.cpu = Utilization(in.Delta(Fixed(before->cpu)));
+    row.ram_kb = in.Delta(before->ram_kb);
+    row.uptime = in.Delta(before->uptime);
+  }
+  if (!in.ok || in.p != in.end) {
+    return 0;
+  }
+  snapshot = std::move(decoded);
+  return next;
+}
+
+// Record a snapshot of the n first processes every interval_ms, count times
+// (0 runs until killed), on the same schedule as the batch mode. Only the
+// files behind the fields a frame keeps are read.
+bool Recording::Run(System& system, const string& path, int interval_ms,
+                    int count, int n, string& error) {
+  Writer writer;
+  if (!writer.Open(path, error)) {
+    return false;
+  }
+  Snapshot snapshot;
+  system.TopN(n);
+  system.Collect(Columns::Sources({Columns::Id::kPid, Columns::Id::kUser,
+                                   Columns::Id::kCpu, Columns::Id::kRam,
+                                   Columns::Id::kTime, Columns::Id::kCommand}));
+  const auto interval = std::chrono::milliseconds(interval_ms);
+  auto next = std::chrono::steady_clock::now();
+  for (int tick = 0; count == 0 || tick < count; ++tick) {
+    if (tick > 0) {
+      std::this_thread::sleep_until(next);
+    }
+    next += interval;
+    system.Refresh();
+    system.TakeSnapshot(snapshot);
+    if (!writer.Append(snapshot)) {
+      error = "cannot write " + path + ": " + std::strerror(errno);
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,60 @@
+#include "refresh_scheduler.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Weight of the newest refresh in the smoothed cost; one slow refresh does
+// not stretch the interval on its own
+constexpr double kSmoothing{0.3};
+
+// CPU time of every thread of the monitor, in nanoseconds
+std::int64_t ProcessCpuTime() {
+  timespec now{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+}  // namespace
+
+RefreshScheduler::RefreshScheduler(std::chrono::milliseconds interval,
+                                   double budget)
+    : base_(interval), budget_(budget), interval_(interval) {}
+
+// Account for the refresh that just finished and return the time to wait
+// before the next one. The first refresh reads every process from scratch,
+// so it only starts the measurement.
+std::chrono::milliseconds RefreshScheduler::Next() {
+  const std::int64_t cpu_ns{ProcessCpuTime()};
+  const auto now = std::chrono::steady_clock::now();
+  if (cpu_ns_ >= 0) {
+    const double cpu{(cpu_ns - cpu_ns_) / 1e9};
+    const double elapsed{std::chrono::duration<double>(now - time_).count()};
+    if (elapsed > 0) {
+      usage_ = static_cast<float>(cpu / elapsed);
+    }
+    cost_ = cost_ < 0 ? cpu : cost_ + kSmoothing * (cpu - cost_);
+    if (budget_ > 0) {
+      const auto wanted = std::chrono::milliseconds(
+          static_cast<long long>(cost_ / budget_ * 1000));
+      interval_ = std::clamp(wanted, Shortest(), base_ * 10);
+    }
+  }
+  cpu_ns_ = cpu_ns;
+  time_ = now;
+  return interval_;
+}
+
+// Return the interval Next() chose last
+std::chrono::milliseconds RefreshScheduler::Interval() const {
+  return interval_;
+}
+
+// Return the shortest interval Next() may choose
+std::chrono::milliseconds RefreshScheduler::Shortest() const {
+  return budget_ > 0 ? base_ / 4 : base_;
+}
+
+// Return the share of a core the monitor used over the last refresh
+float RefreshScheduler::Usage() const { return usage_; }
@@ -0,0 +1,215 @@
+#include "rollups.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_file.h"
+
+using std::size_t;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+// Return the number at the start of contents, or -1
+long long Number(string_view contents) {
+  long long value{-1};
+  std::from_chars(contents.data(), contents.data() + contents.size(), value);
+  return value;
+}
+
+// Return the value of the "usage_usec" line of a cpu.stat file, or -1
+long long UsageUsec(string_view contents) {
+  constexpr string_view kKey{"usage_usec "};
+  size_t start = 0;
+  while (start < contents.size()) {
+    if (contents.compare(start, kKey.size(), kKey) == 0) {
+      return Number(contents.substr(start + kKey.size()));
+    }
+    start = contents.find('\n', start);
+    if (start == string_view::npos) {
+      break;
+    }
+    ++start;
+  }
+  return -1;
+}
+
+// Order rows by the sort key, falling back to their names
+template <typename Row>
+void Sort(SortKey key, vector<Row>& rows) {
+  std::sort(rows.begin(), rows.end(), [key](const Row& a, const Row& b) {
+    if (key == SortKey::kCpu && a.cpu != b.cpu) {
+      return a.cpu > b.cpu;
+    }
+    if (key == SortKey::kRam && a.ram_kb != b.ram_kb) {
+      return a.ram_kb > b.ram_kb;
+    }
+    return a.name < b.name;
+  });
+}
+}  // namespace
+
+// Return the id of the cgroup at path, which the cgroup keeps while it has
+// processes; -1 for an empty path
+int Rollups::Cgroup(string_view path) {
+  if (path.empty()) {
+    return -1;
+  }
+  key_.assign(path);
+  const auto it = ids_.find(key_);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  int id;
+  if (free_.empty()) {
+    id = cgroups_.size();
+    cgroups_.emplace_back();
+  } else {
+    id = free_.back();
+    free_.pop_back();
+  }
+  Group& group = cgroups_[id];
+  group.path = path;
+  // The root's cpu.stat counts the whole system, other groups included, and
+  // it has no memory.current: its own processes are summed instead
+  const string& mount = LinuxParser::CgroupMount();
+  if (!mount.empty() && path != "/") {
+    group.cpu_stat = std::make_unique<ProcFile>(mount + key_ + "/cpu.stat");
+    group.memory = std::make_unique<ProcFile>(mount + key_ + "/memory.current");
+  }
+  ids_.emplace(key_, id);
+  return id;
+}
+
+void Rollups::Begin() {
+  for (auto& group : cgroups_) {
+    group.totals = Totals{};
+  }
+  for (auto& [uid, totals] : users_) {
+    totals = Totals{};
+  }
+}
+
+// Add one process to its cgroup, if known, and to its user
+void Rollups::Add(int cgroup, int uid, float cpu, long ram_kb) {
+  if (cgroup >= 0) {
+    Totals& totals = cgroups_[cgroup].totals;
+    ++totals.processes;
+    totals.cpu += cpu;
+    totals.ram_kb += ram_kb;
+  }
+  Totals& totals = users_[uid];
+  ++totals.processes;
+  totals.cpu += cpu;
+  totals.ram_kb += ram_kb;
+}
+
+// Retire the groups left without processes and, if measure, read the cgroup
+// files of the others. Returns the number of groups retired; their ids may
+// be given to other paths from now on.
+size_t Rollups::End(bool measure) {
+  size_t retired{0};
+  for (size_t id = 0; id < cgroups_.size(); ++id) {
+    Group& group = cgroups_[id];
+    if (group.path.empty()) {
+      continue;
+    }
+    if (group.totals.processes > 0) {
+      if (measure) {
+        Measure(group);
+      } else {
+        // The next measurement starts over rather than averaging over the
+        // ticks in between
+        group.usage_usec = -1;
+      }
+      continue;
+    }
+    ids_.erase(group.path);
+    group = Group{};
+    free_.push_back(id);
+    ++retired;
+  }
+  for (auto it = users_.begin(); it != users_.end();) {
+    if (it->second.processes == 0) {
+      it = users_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return retired;
+}
+
+// Return whether cgroup is the id of a group that has not been retired
+bool Rollups::Live(int cgroup) const {
+  return cgroup >= 0 && static_cast<size_t>(cgroup) < cgroups_.size() &&
+         !cgroups_[cgroup].path.empty();
+}
+
+// Replace the sums of the processes of a cgroup with what the cgroup itself
+// accounts for. CPU needs two readings, so the first tick keeps the sum.
+void Rollups::Measure(Group& group) {
+  string_view contents;
+  if (group.cpu_stat) {
+    const auto now = std::chrono::steady_clock::now();
+    const long long usage{group.cpu_stat->Read(contents) ? UsageUsec(contents)
+                                                         : -1};
+    if (usage < 0) {
+      group.cpu_stat.reset();
+    } else {
+      const double elapsed_usec{
+          std::chrono::duration<double, std::micro>(now - group.read).count()};
+      if (group.usage_usec >= 0 && elapsed_usec > 0) {
+        group.totals.cpu = (usage - group.usage_usec) / elapsed_usec;
+      }
+      group.usage_usec = usage;
+      group.read = now;
+    }
+  }
+  if (group.memory) {
+    const long long bytes{group.memory->Read(contents) ? Number(contents)
+                                                       : -1};
+    if (bytes < 0) {
+      group.memory.reset();
+    } else {
+      group.totals.ram_kb = bytes / 1024;
+    }
+  }
+}
+
+// Copy the first n cgroups and users in sort order. CPU and memory order by
+// the largest first; every other key orders by name. The cgroups are ranked
+// by reference and only the first n copied, into the rows cgroups already
+// holds.
+void Rollups::Fill(SortKey key, size_t n, vector<GroupRow>& cgroups,
+                   vector<GroupRow>& users) {
+  ranked_.clear();
+  for (const auto& group : cgroups_) {
+    if (!group.path.empty()) {
+      ranked_.push_back(Ranked{group.path, group.totals.processes,
+                               group.totals.cpu, group.totals.ram_kb});
+    }
+  }
+  Sort(key, ranked_);
+  cgroups.resize(std::min(n, ranked_.size()));
+  for (size_t i = 0; i < cgroups.size(); ++i) {
+    cgroups[i].name.assign(ranked_[i].name);
+    cgroups[i].processes = ranked_[i].processes;
+    cgroups[i].cpu = ranked_[i].cpu;
+    cgroups[i].ram_kb = ranked_[i].ram_kb;
+  }
+
+  users.clear();
+  for (const auto& [uid, totals] : users_) {
+    users.push_back(GroupRow{LinuxParser::UserName(uid), totals.processes,
+                             totals.cpu, totals.ram_kb});
+  }
+  Sort(key, users);
+  users.resize(std::min(n, users.size()));
+}
@@ -2,11 +2,15 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "instrumentation.h"
 #include "linux_parser.h"
 #include "process.h"
 #include "processor.h"
@@ -16,38 +20,662 @@ using std::size_t;
 using std::string;
 using std::vector;
 
+namespace {
+// Processes can change user or move to another cgroup without exec, as
+// services do right after they fork, so the status and cgroup of each PID are
+// read again every so many refreshes
+constexpr unsigned long kRecheckInterval{16};
+
+// Fill in the fields of a filter record that come from stat
+void Describe(const LinuxParser::ProcStat& stat, long up_time,
+              Filter::Record& record) {
+  static const long page_kilobytes{sysconf(_SC_PAGESIZE) / 1024};
+  record.has_stat = true;
+  record.ppid = stat.ppid;
+  record.state = stat.state;
+  record.comm = stat.comm;
+  record.ram_kb = stat.rss * page_kilobytes;
+  record.uptime = up_time - stat.starttime / LinuxParser::ClockTicksPerSecond();
+}
+}  // namespace
+
+//  Collect processes with the given number of workers; 1 collects on the
+//  calling thread only. New processes are found with the discovery backend.
+System::System(int workers, ProcessDiscovery::Backend discovery)
+    : discovery_(discovery),
+      pool_(workers),
+      samples_(pool_.Size()),
+      arenas_(pool_.Size()) {}
+
+//  Return the discovery backend in use
+ProcessDiscovery::Backend System::Discovery() const {
+  return discovery_.Active();
+}
+
 //  Return the system's CPU
 Processor& System::Cpu() { return cpu_; }
 
+//  Collect a new sample of the system. /proc/stat is read once and shared by
+//  the CPU and the process table.
+void System::Refresh() {
+  memory_utilization_ =
+      LinuxParser::ReadMemInfo(meminfo_) ? meminfo_.Utilization() : 0;
+  UpdatePaging();
+  has_pressure_ = true;
+  for (int resource = 0; resource < LinuxParser::kPressureResources;
+       ++resource) {
+    has_pressure_ &= LinuxParser::ReadPressure(
+        static_cast<LinuxParser::PressureResource>(resource),
+        pressure_[resource]);
+  }
+  up_time_ = LinuxParser::UpTime();
+  LinuxParser::LoadAverage(load_average_);
+  LinuxParser::ReadStatSnapshot(stat_);
+  cpu_.Update(stat_);
+  const long cores = std::max<long>(1, stat_.cores.size());
+  system_jiffies_ = stat_.cpu.Total() / cores;
+  UpdateProcesses(system_jiffies_);
+  UpdateThreads();
+  RecordHistory();
+  cost_ = Instrumentation::Collect();
+}
+
+//  Turn the paging counters of /proc/vmstat into rates since the previous
+//  refresh
+void System::UpdatePaging() {
+  LinuxParser::VmStat vmstat;
+  if (!LinuxParser::ReadVmStat(vmstat)) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  if (vmstat_time_ != std::chrono::steady_clock::time_point{}) {
+    const float seconds{
+        std::chrono::duration<float>(now - vmstat_time_).count()};
+    if (seconds > 0) {
+      paging_rates_[0] = (vmstat.pgfault - vmstat_.pgfault) / seconds;
+      paging_rates_[1] = (vmstat.pgmajfault - vmstat_.pgmajfault) / seconds;
+      paging_rates_[2] = (vmstat.pswpin - vmstat_.pswpin) / seconds;
+      paging_rates_[3] = (vmstat.pswpout - vmstat_.pswpout) / seconds;
+    }
+  }
+  vmstat_ = vmstat;
+  vmstat_time_ = now;
+}
+
 //  Return a container composed of the system's processes
-vector<Process>& System::Processes() {
-  processes_.clear();
-  auto pids{LinuxParser::Pids()};
+vector<Process>& System::Processes() { return processes_; }
+
+//  Update the process table. It persists across refreshes: new PIDs are
+//  inserted, exited PIDs retired and survivors updated in place so that their
+//  CPU utilization covers only the last interval.
+//  The /proc reads are spread over the worker pool; each worker appends to its
+//  own sample buffer and the buffers are merged into the table afterwards.
+void System::UpdateProcesses(long system_jiffies) {
+  ++refresh_count_;
+  const auto& pids{discovery_.Pids()};
+  const unsigned sources{Needed()};
+
+  {
+    MONITOR_TIME_PHASE(kParse);
+    // Last refresh's samples go first, then the arenas their strings were in
+    for (auto& samples : samples_) {
+      samples.clear();
+    }
+    for (auto& arena : arenas_) {
+      arena.Reset();
+    }
+    for (const int pid : discovery_.Execs()) {
+      const auto it = table_.find(pid);
+      if (it != table_.end()) {
+        it->second.exec = true;
+      }
+    }
+    pool_.Run(pids.size(), [&](int worker, std::size_t index) {
+      Sample sample(arenas_[worker].Resource());
+      const int pid{pids[index]};
+      Filter::Record record;
+      record.pid = pid;
+      if (filter_.Evaluate(record) == Filter::Match::kNo) {
+        return;
+      }
+      // The process may have exited since the directory scan
+      if (!LinuxParser::ReadProcStat(pid, sample.stat)) {
+        return;
+      }
+      // The table is only read while the workers run. Known processes only
+      // need their stat, unless they called exec, which a new comm reveals
+      // when the discovery backend does not.
+      const auto it = table_.find(pid);
+      const bool known{it != table_.end() &&
+                       it->second.process.StartTime() == sample.stat.starttime};
+      sample.exec = known && (it->second.exec ||
+                              it->second.process.Comm() != sample.stat.comm);
+      // Filtered processes stay in the table with what is known of them, so
+      // the files of one the filter rejects are not read at all
+      if (!filter_.Empty()) {
+        Describe(sample.stat, up_time_, record);
+        if (known && !sample.exec) {
+          record.uid = it->second.process.Uid();
+          if (const string* command = it->second.process.KnownCommand()) {
+            record.command = *command;
+          }
+        }
+        sample.match = filter_.Evaluate(record);
+        if (sample.match == Filter::Match::kNo) {
+          samples_[worker].push_back(std::move(sample));
+          return;
+        }
+      }
+      // Status and cgroup are only read when something shown needs them
+      const bool recheck{!known || sample.exec ||
+                         (pid + refresh_count_) % kRecheckInterval == 0};
+      if ((sources & Columns::kStatus) &&
+          (recheck || it->second.process.Uid() < 0)) {
+        if (!LinuxParser::ReadProcStatus(pid, sample.status)) {
+          return;
+        }
+        sample.has_status = true;
+        if (!filter_.Empty()) {
+          record.uid = sample.status.uid;
+          sample.match = filter_.Evaluate(record);
+        }
+      }
+      if ((sources & Columns::kCgroup) &&
+          (recheck || !it->second.cgroup_read)) {
+        sample.cgroup_read = true;
+        sample.has_cgroup = LinuxParser::ReadProcCgroup(pid, sample.cgroup);
+      }
+      if (sample.match == Filter::Match::kUnknown &&
+          !record.command &&
+          filter_.Reads(Filter::Cost::kCmdline)) {
+        LinuxParser::Command(pid, sample.command);
+        sample.has_command = true;
+        record.command = sample.command;
+        sample.match = filter_.Evaluate(record);
+      }
+      samples_[worker].push_back(std::move(sample));
+    });
+
+    for (const auto& samples : samples_) {
+      for (const auto& sample : samples) {
+        Merge(sample, system_jiffies);
+      }
+    }
+
+    // What the workers left undecided needs the CPU utilization, known now
+    for (auto it = table_.begin(); it != table_.end();) {
+      if (it->second.last_seen != refresh_count_) {
+        it = table_.erase(it);
+      } else {
+        if (it->second.match == Filter::Match::kUnknown) {
+          it->second.match = Screen(it->second.process);
+        }
+        ++it;
+      }
+    }
+    Rollup();
+  }
+  Select();
+  ReadDetails();
+}
+
+//  Add up the table by cgroup and by user. Nothing is rolled up while the
+//  group files are not collected: with nothing added every group would be
+//  retired and its id handed to another path, while table entries still
+//  refer to it.
+void System::Rollup() {
+  if ((Needed() & Columns::kGroupSources) != Columns::kGroupSources) {
+    return;
+  }
+  rollups_.Begin();
+  for (const auto& [pid, entry] : table_) {
+    if (entry.match != Filter::Match::kYes) {
+      continue;
+    }
+    const Process& process = entry.process;
+    rollups_.Add(entry.cgroup, process.Uid(), process.CpuUtilization(),
+                 process.RamKilobytes());
+  }
+  // The cgroup files count the processes a filter hides as well, so a
+  // filtered table keeps the sums of the processes that match
+  if (rollups_.End(filter_.Empty()) == 0) {
+    return;
+  }
+  // A group whose processes the filter hides all of is retired too. The
+  // hidden entries forget its id, which may go to another path, and read
+  // their cgroup again once they match.
+  for (auto& [pid, entry] : table_) {
+    if (entry.cgroup >= 0 && !rollups_.Live(entry.cgroup)) {
+      entry.cgroup = -1;
+      entry.cgroup_read = false;
+    }
+  }
+}
+
+//  Sort Processes() by key from now on
+void System::SortBy(SortKey key) {
+  sort_key_ = key;
+  Select();
+  ReadDetails();
+}
+
+//  Return the key Processes() is sorted by
+System::SortKey System::SortedBy() const { return sort_key_; }
+
+//  Limit Processes() to the first n processes in sort order
+void System::TopN(int n) {
+  top_n_ = std::max(0, n);
+  Select();
+  ReadDetails();
+}
+
+//  Collect the threads of process pid from now on, or of none with -1. They
+//  are read right away; like a new process, a thread first shows its
+//  lifetime average.
+void System::ShowThreads(int pid) {
+  threads_pid_ = pid;
+  threads_.clear();
+  UpdateThreads();
+}
+
+//  Show only the processes filter matches from now on. The table is screened
+//  again with what is known of each process; one missing a field the filter
+//  needs is hidden until the next refresh reads it.
+void System::SetFilter(const Filter& filter) {
+  filter_ = filter;
+  for (auto& [pid, entry] : table_) {
+    entry.match = Screen(entry.process);
+  }
+  Rollup();
+  Select();
+  ReadDetails();
+}
+
+//  Read the files in sources for every process from now on, and the others
+//  only when the sort key or the filter needs them; see Columns::Source
+void System::Collect(unsigned sources) {
+  sources_ = sources;
+  Rollup();
+  ReadDetails();
+}
+
+//  Return the sources given to Collect()
+unsigned System::Collected() const { return sources_; }
+
+//  Return the files to read per process, for display, sorting and filtering
+unsigned System::Needed() const {
+  unsigned sources{sources_ | Columns::Sources(sort_key_)};
+  if (filter_.Reads(Filter::Cost::kStatus)) {
+    sources |= Columns::kStatus;
+  }
+  return sources;
+}
+
+//  Return the process whose threads are collected, or -1
+int System::ThreadsShown() const { return threads_pid_; }
+
+//  Update the thread table of the process whose threads are shown. Only its
+//  task directory is read, so the cost follows its number of threads rather
+//  than the number of processes on the system.
+void System::UpdateThreads() {
+  thread_order_.clear();
+  if (threads_pid_ < 0) {
+    return;
+  }
+  MONITOR_TIME_PHASE(kParse);
+  LinuxParser::ProcStat stat;
+  LinuxParser::Tids(threads_pid_, tids_);
+  for (const int tid : tids_) {
+    if (!LinuxParser::ReadTaskStat(threads_pid_, tid, stat)) {
+      continue;
+    }
+    auto it = threads_.find(tid);
+    if (it == threads_.end() ||
+        it->second.process.StartTime() != stat.starttime) {
+      Process p(stat);
+      p.CpuUtilization(p.ActiveJiffies(), system_jiffies_);
+      it = threads_
+               .insert_or_assign(tid, Thread{p, stat.state, stat.comm,
+                                             refresh_count_})
+               .first;
+    } else {
+      it->second.process.Update(stat, system_jiffies_);
+      it->second.state = stat.state;
+      it->second.last_seen = refresh_count_;
+    }
+  }
+  for (auto it = threads_.begin(); it != threads_.end();) {
+    if (it->second.last_seen != refresh_count_) {
+      it = threads_.erase(it);
+    } else {
+      thread_order_.push_back(&it->second);
+      ++it;
+    }
+  }
+  const auto n = std::min(top_n_, thread_order_.size());
+  std::partial_sort(thread_order_.begin(), thread_order_.begin() + n,
+                    thread_order_.end(), [](const Thread* a, const Thread* b) {
+                      if (a->process.CpuUtilization() !=
+                          b->process.CpuUtilization()) {
+                        return a->process > b->process;
+                      }
+                      return a->process.Pid() < b->process.Pid();
+                    });
+  thread_order_.resize(n);
+}
+
+//  Keep window of history from now on, dropping what was kept. interval is
+//  the shortest time between refreshes, for which the rings are sized.
+void System::KeepHistory(std::chrono::milliseconds window,
+                         std::chrono::milliseconds interval) {
+  history_ = History(History::CapacityFor(window.count(), interval.count()),
+                     window.count());
+}
+
+//  Add this refresh to the history. Every process in Processes() gets a slot;
+//  tracked processes are recorded as long as they live.
+void System::RecordHistory() {
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  history_.Begin(
+      std::chrono::duration_cast<std::chrono::milliseconds>(now).count(),
+      cpu_.Utilization(), memory_utilization_, cpu_.CoreUtilization());
+  for (const auto& process : processes_) {
+    history_.Track(process.Pid(), process.StartTime());
+  }
+  for (std::size_t slot = 0; slot < History::kSlots; ++slot) {
+    const int pid = history_.SlotPid(slot);
+    if (pid < 0) {
+      continue;
+    }
+    const auto it = table_.find(pid);
+    if (it != table_.end() &&
+        it->second.process.StartTime() == history_.SlotStartTime(slot)) {
+      const Process& process = it->second.process;
+      history_.Record(slot, process.CpuUtilization(), process.RamKilobytes());
+    }
+  }
+  history_.End();
+}
+
+//  Pick the first top_n_ processes of the table in sort order. Only those are
+//  sorted, with a bounded heap over the rest, and copied to processes_.
+void System::Select() {
+  MONITOR_TIME_PHASE(kSort);
+  candidates_.clear();
+  for (const auto& [pid, entry] : table_) {
+    if (entry.match == Filter::Match::kYes) {
+      candidates_.push_back(&entry.process);
+    }
+  }
+
+  // Users are ordered by name; rank each distinct UID once instead of looking
+  // names up in every comparison
+  user_rank_.clear();
+  if (sort_key_ == SortKey::kUser) {
+    vector<std::pair<string, int>> users;
+    for (const auto* process : candidates_) {
+      if (user_rank_.emplace(process->Uid(), 0).second) {
+        users.emplace_back(process->User(), process->Uid());
+      }
+    }
+    std::sort(users.begin(), users.end());
+    for (std::size_t i = 0; i < users.size(); ++i) {
+      user_rank_[users[i].second] = i;
+    }
+  }
 
-  for (const auto& pid : pids) {
-    Process p(pid);
-    p.CpuUtilization(LinuxParser::ActiveJiffies(pid), LinuxParser::Jiffies());
-    processes_.push_back(p);
+  const auto n = std::min(top_n_, candidates_.size());
+  std::partial_sort(
+      candidates_.begin(), candidates_.begin() + n, candidates_.end(),
+      [this](const Process* a, const Process* b) { return Before(*a, *b); });
+  // Assigned rather than rebuilt, so the rows keep their strings' storage
+  if (processes_.size() > n) {
+    processes_.erase(processes_.begin() + n, processes_.end());
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i < processes_.size()) {
+      processes_[i] = *candidates_[i];
+    } else {
+      processes_.push_back(*candidates_[i]);
+    }
   }
-  // We needed to define the > operator for this to work
-  std::sort(processes_.begin(), processes_.end(), std::greater<Process>());
-  return processes_;
+}
+
+//  Resolve the command line and user of the processes in Processes(), once
+//  per lifetime, and read the columns that are only shown, never sorted by.
+//  Their files are expensive for the kernel to generate, so they are read at
+//  most once per refresh, only for these processes and only if collected; a
+//  process first read now gets its I/O rates from the next reading.
+void System::ReadDetails() {
+  MONITOR_TIME_PHASE(kParse);
+  const auto now = std::chrono::steady_clock::now();
+  const unsigned sources{Needed()};
+  for (auto& process : processes_) {
+    const auto it = table_.find(process.Pid());
+    if (it == table_.end()) {
+      continue;
+    }
+    Entry& entry = it->second;
+    if (sources & Columns::kCmdline) {
+      entry.process.ResolveCommand();
+    }
+    if (entry.process.Uid() >= 0) {
+      entry.process.ResolveUser();
+    }
+    if (entry.details_read != refresh_count_) {
+      entry.details_read = refresh_count_;
+      LinuxParser::ProcIo io;
+      if ((sources & Columns::kIo) &&
+          LinuxParser::ReadProcIo(process.Pid(), io)) {
+        entry.process.Update(io, now);
+      }
+      LinuxParser::ProcMemory memory;
+      if ((sources & Columns::kSmapsRollup) &&
+          LinuxParser::ReadProcMemory(process.Pid(), memory)) {
+        entry.process.Update(memory);
+      }
+    }
+    process = entry.process;
+  }
+}
+
+//  Return whether a is listed before b. Ties on the sort key are broken by
+//  PID so that equal rows keep their order from one refresh to the next.
+bool System::Before(const Process& a, const Process& b) const {
+  switch (sort_key_) {
+    case SortKey::kCpu:
+      if (a.CpuUtilization() != b.CpuUtilization()) {
+        return a > b;
+      }
+      break;
+    case SortKey::kRam:
+      if (a.RamKilobytes() != b.RamKilobytes()) {
+        return a.RamKilobytes() > b.RamKilobytes();
+      }
+      break;
+    case SortKey::kUpTime:
+      // Oldest first, i.e. the longest up time
+      if (a.StartTime() != b.StartTime()) {
+        return a.StartTime() < b.StartTime();
+      }
+      break;
+    case SortKey::kUser: {
+      const int rank_a = user_rank_.at(a.Uid());
+      const int rank_b = user_rank_.at(b.Uid());
+      if (rank_a != rank_b) {
+        return rank_a < rank_b;
+      }
+      break;
+    }
+    case SortKey::kPid:
+      break;
+  }
+  return a.Pid() < b.Pid();
+}
+
+//  Insert or update the table entry of one sampled process
+void System::Merge(const Sample& sample, long system_jiffies) {
+  const auto& stat = sample.stat;
+  auto it = table_.find(stat.pid);
+  // A different start time means the PID has been reused
+  if (it == table_.end() ||
+      it->second.process.StartTime() != stat.starttime) {
+    Process p(stat);
+    p.CpuUtilization(p.ActiveJiffies(), system_jiffies);
+    it = table_.insert_or_assign(stat.pid, Entry{p, refresh_count_}).first;
+  } else {
+    it->second.process.Update(stat, system_jiffies);
+    it->second.last_seen = refresh_count_;
+    if (sample.exec) {
+      it->second.process.Exec();
+      it->second.exec = false;
+    }
+  }
+  if (sample.has_status) {
+    it->second.process.Update(sample.status);
+  }
+  if (sample.has_command) {
+    it->second.process.Command(string(sample.command));
+  }
+  it->second.match = sample.match;
+  if (sample.cgroup_read) {
+    it->second.cgroup_read = true;
+    it->second.cgroup =
+        sample.has_cgroup ? rollups_.Cgroup(sample.cgroup) : -1;
+  }
+}
+
+//  Evaluate the filter with everything the table knows of a process
+Filter::Match System::Screen(const Process& process) const {
+  Filter::Record record;
+  record.pid = process.Pid();
+  record.has_stat = true;
+  record.ppid = process.ParentPid();
+  record.state = process.State();
+  record.comm = process.Comm();
+  record.ram_kb = process.RamKilobytes();
+  record.uptime =
+      up_time_ - process.StartTime() / LinuxParser::ClockTicksPerSecond();
+  record.uid = process.Uid();
+  if (const string* command = process.KnownCommand()) {
+    record.command = *command;
+  }
+  record.cpu = process.CpuUtilization();
+  return filter_.Evaluate(record);
 }
 
 //  Return the system's kernel identifier (string)
-std::string System::Kernel() { return LinuxParser::Kernel(); }
+std::string System::Kernel() {
+  if (kernel_.empty()) {
+    kernel_ = LinuxParser::Kernel();
+  }
+  return kernel_;
+}
 
 //  Return the system's memory utilization
-float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
+float System::MemoryUtilization() { return memory_utilization_; }
 
 //  Return the operating system name
-std::string System::OperatingSystem() { return LinuxParser::OperatingSystem(); }
+std::string System::OperatingSystem() {
+  if (operating_system_.empty()) {
+    operating_system_ = LinuxParser::OperatingSystem();
+  }
+  return operating_system_;
+}
 
 //  Return the number of processes actively running on the system
-int System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+int System::RunningProcesses() { return stat_.procs_running; }
 
 //  Return the total number of processes on the system
-int System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+int System::TotalProcesses() { return stat_.processes; }
 
 //  Return the number of seconds since the system started running
-long int System::UpTime() { return LinuxParser::UpTime(); }
\ No newline at end of file
+long int System::UpTime() { return up_time_; }
+
+//  Return the monitor's own cost since the previous Refresh(): the latest
+//  collection and whatever was rendered from the previous one
+const Instrumentation::Tick& System::Cost() const { return cost_; }
+
+//  Copy the latest sample into snapshot, reusing its storage
+void System::TakeSnapshot(Snapshot& snapshot) {
+  snapshot.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  if (snapshot.operating_system.empty()) {
+    snapshot.operating_system = OperatingSystem();
+    snapshot.kernel = Kernel();
+  }
+  snapshot.cpu = cpu_.Utilization();
+  snapshot.cores = cpu_.CoreUtilization();
+  snapshot.memory = memory_utilization_;
+  snapshot.meminfo = meminfo_;
+  snapshot.page_faults = paging_rates_[0];
+  snapshot.major_faults = paging_rates_[1];
+  snapshot.swap_ins = paging_rates_[2];
+  snapshot.swap_outs = paging_rates_[3];
+  snapshot.has_pressure = has_pressure_;
+  std::copy(pressure_, pressure_ + LinuxParser::kPressureResources,
+            snapshot.pressure);
+  snapshot.uptime = up_time_;
+  std::copy(load_average_, load_average_ + 3, snapshot.load_average);
+  snapshot.total_processes = TotalProcesses();
+  snapshot.running_processes = RunningProcesses();
+  snapshot.live_processes = table_.size();
+  snapshot.sort_key = sort_key_;
+  snapshot.filter = filter_.Text();
+  snapshot.matches = filter_.Empty() ? 0 : candidates_.size();
+  snapshot.cost = cost_;
+  snapshot.history_length = history_.Length();
+  history_.Cpu(snapshot.cpu_history);
+  history_.Memory(snapshot.memory_history);
+  snapshot.core_history.resize(history_.Cores());
+  for (std::size_t core = 0; core < history_.Cores(); ++core) {
+    history_.Core(core, snapshot.core_history[core]);
+  }
+
+  const long hertz = LinuxParser::ClockTicksPerSecond();
+  snapshot.processes.resize(processes_.size());
+  for (std::size_t i = 0; i < processes_.size(); ++i) {
+    const Process& process = processes_[i];
+    ProcessRow& row = snapshot.processes[i];
+    row.pid = process.Pid();
+    row.uid = process.Uid();
+    // Left empty when not collected. Assigned in place to keep the rows'
+    // storage from one snapshot to the next.
+    const string* command = process.KnownCommand();
+    if (process.Uid() >= 0) {
+      row.user.assign(process.User());
+    } else {
+      row.user.clear();
+    }
+    if (command != nullptr) {
+      row.command.assign(*command);
+    } else {
+      row.command.clear();
+    }
+    row.cpu = process.CpuUtilization();
+    row.ram_kb = process.RamKilobytes();
+    row.pss_kb = process.PssKilobytes();
+    row.swap_kb = process.SwapKilobytes();
+    row.read_rate = process.ReadRate();
+    row.write_rate = process.WriteRate();
+    row.major_fault_rate = process.MajorFaultRate();
+    row.uptime = up_time_ - process.StartTime() / hertz;
+    history_.Process(row.pid, row.cpu_history, row.rss_history);
+  }
+  snapshot.threads_pid = threads_pid_;
+  snapshot.threads.resize(thread_order_.size());
+  for (std::size_t i = 0; i < thread_order_.size(); ++i) {
+    const Thread& thread = *thread_order_[i];
+    ThreadRow& row = snapshot.threads[i];
+    row.tid = thread.process.Pid();
+    row.name = thread.name;
+    row.state = thread.state;
+    row.cpu = thread.process.CpuUtilization();
+    row.uptime = up_time_ - thread.process.StartTime() / hertz;
+  }
+  rollups_.Fill(sort_key_, top_n_, snapshot.cgroups, snapshot.users);
+}
+
+//  Return the 1, 5 and 15 minute load averages
+const float* System::LoadAverage() const { return load_average_; }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "tick_arena.h"
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace {
+// Initial buffer size, enough for the cgroup paths of a few hundred
+// processes
+constexpr std::size_t kInitialSize{16384};
+}  // namespace
+
+TickArena::TickArena() : buffer_(kInitialSize) {
+  resource_.emplace(buffer_.data(), buffer_.size(), &overflow_);
+}
+
+// Return the resource to allocate from until the next Reset()
+std::pmr::memory_resource* TickArena::Resource() { return &*resource_; }
+
+// Release everything allocated since the previous Reset(). Nothing allocated
+// from Resource() may be used afterwards.
+void TickArena::Reset() {
+  if (overflow_.bytes == 0) {
+    resource_->release();
+    return;
+  }
+  // Grow by what overflowed, with room to spare for the next refresh
+  resource_.reset();
+  buffer_.resize((buffer_.size() + overflow_.bytes) * 2);
+  overflow_.bytes = 0;
+  resource_.emplace(buffer_.data(), buffer_.size(), &overflow_);
+}
+
+void* TickArena::Overflow::do_allocate(std::size_t bytes,
+                                       std::size_t alignment) {
+  this->bytes += bytes;
+  return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void TickArena::Overflow::do_deallocate(void* pointer, std::size_t bytes,
+                                        std::size_t alignment) {
+  std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+bool TickArena::Overflow::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
@@ -0,0 +1,83 @@
+#include "watcher.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::to_string;
+
+Watcher::Watcher(const std::vector<int>& pids) {
+  for (const int pid : pids) {
+    const std::string directory{LinuxParser::ProcDirectory() + to_string(pid)};
+    Watched watched;
+    watched.pid = pid;
+    watched.stat =
+        std::make_unique<ProcFile>(directory + LinuxParser::kStatFilename);
+    // Clocks of real processes only, not those of a synthetic tree
+    watched.has_clock =
+        LinuxParser::ProcDirectory() == LinuxParser::kProcDirectory &&
+        clock_getcpuclockid(pid, &watched.clock) == 0;
+    watched_.push_back(std::move(watched));
+  }
+}
+
+// Sample every watched process into samples, exits included. Returns false
+// once no process is left to watch.
+bool Watcher::Read(std::vector<Sample>& samples) {
+  static const long page_kilobytes{sysconf(_SC_PAGESIZE) / 1024};
+  const long hertz{LinuxParser::ClockTicksPerSecond()};
+  const auto now = std::chrono::steady_clock::now();
+  samples.clear();
+  for (auto it = watched_.begin(); it != watched_.end();) {
+    Watched& watched = *it;
+    Sample sample;
+    sample.pid = watched.pid;
+    std::string_view contents;
+    LinuxParser::ProcStat stat;
+    // A reopened stat of a reused PID has another start time
+    if (!watched.stat->Read(contents) ||
+        !LinuxParser::ParseProcStat(contents.data(), contents.size(), stat) ||
+        (watched.start_time >= 0 && stat.starttime != watched.start_time)) {
+      sample.exited = true;
+      samples.push_back(sample);
+      it = watched_.erase(it);
+      continue;
+    }
+    // CPU time of every thread of the process, in nanoseconds
+    timespec clock_time{};
+    const long run_ns{
+        watched.has_clock && clock_gettime(watched.clock, &clock_time) == 0
+            ? clock_time.tv_sec * 1000000000L + clock_time.tv_nsec
+            : -1};
+    const long jiffies{stat.utime + stat.stime};
+    sample.state = stat.state;
+    sample.ram_kb = stat.rss * page_kilobytes;
+    const double seconds{
+        std::chrono::duration<double>(now - watched.time).count()};
+    if (watched.start_time >= 0 && seconds > 0) {
+      sample.cpu = static_cast<float>(
+          run_ns >= 0 && watched.run_ns >= 0
+              ? (run_ns - watched.run_ns) / 1e9 / seconds
+              : static_cast<double>(jiffies - watched.jiffies) / hertz /
+                    seconds);
+      sample.major_fault_rate =
+          static_cast<float>((stat.majflt - watched.majflt) / seconds);
+    }
+    watched.start_time = stat.starttime;
+    watched.run_ns = run_ns;
+    watched.jiffies = jiffies;
+    watched.majflt = stat.majflt;
+    watched.time = now;
+    samples.push_back(sample);
+    ++it;
+  }
+  return !watched_.empty();
+}
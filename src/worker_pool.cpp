@@ -0,0 +1,101 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+// Number of indices claimed at once; small enough to balance the load,
+// large enough to keep the atomic traffic low
+constexpr std::size_t kChunkSize{16};
+
+WorkerPool::WorkerPool(int workers)
+    : shards_(new Shard[std::max(1, workers)]), size_(std::max(1, workers)) {
+  for (int worker = 1; worker < size_; ++worker) {
+    threads_.emplace_back(&WorkerPool::Loop, this, worker);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+// Return the number of workers, including the calling thread
+int WorkerPool::Size() const { return size_; }
+
+// Run job for every index in [0, count) and wait until all have finished
+void WorkerPool::Run(std::size_t count, const Job& job) {
+  const std::size_t shard_size = (count + size_ - 1) / size_;
+  for (int worker = 0; worker < size_; ++worker) {
+    const std::size_t begin = std::min(count, worker * shard_size);
+    shards_[worker].next.store(begin, std::memory_order_relaxed);
+    shards_[worker].end = std::min(count, begin + shard_size);
+  }
+  if (size_ == 1) {
+    job_ = &job;
+    Work(0);
+    job_ = nullptr;
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  job_ = &job;
+  running_ = size_ - 1;
+  ++generation_;
+  lock.unlock();
+  start_.notify_all();
+
+  Work(0);
+
+  lock.lock();
+  done_.wait(lock, [this] { return running_ == 0; });
+  job_ = nullptr;
+}
+
+// Drain the worker's own shard, then steal from the others
+void WorkerPool::Work(int worker) {
+  std::size_t begin, end;
+  for (int i = 0; i < size_; ++i) {
+    Shard& shard = shards_[(worker + i) % size_];
+    while (Claim(shard, begin, end)) {
+      for (std::size_t index = begin; index < end; ++index) {
+        (*job_)(worker, index);
+      }
+    }
+  }
+}
+
+// Claim the next chunk of a shard, returning false once it is exhausted
+bool WorkerPool::Claim(Shard& shard, std::size_t& begin, std::size_t& end) {
+  begin = shard.next.fetch_add(kChunkSize, std::memory_order_relaxed);
+  if (begin >= shard.end) {
+    return false;
+  }
+  end = std::min(shard.end, begin + kChunkSize);
+  return true;
+}
+
+// Body of a pool thread: wait for a job, work on it, report completion
+void WorkerPool::Loop(int worker) {
+  unsigned long seen{0};
+  while (true) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+    if (stop_) {
+      return;
+    }
+    seen = generation_;
+    lock.unlock();
+
+    Work(worker);
+
+    lock.lock();
+    if (--running_ == 0) {
+      done_.notify_one();
+    }
+  }
+}